@@ -0,0 +1,101 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+
+#define BOOST_TEST_MODULE Background_grid
+#include <boost/test/unit_test.hpp>
+
+#include "Background_grid.h"
+#include "Delaunay_mesher.h"
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Polygon.h"
+#include "Triangulator.h"
+
+#include <boost/ref.hpp>
+
+#include <cmath>
+
+using namespace umeshu;
+
+typedef Delaunay_triangulation<Delaunay_triangulation_items> Mesh;
+typedef Mesh::Kernel                  Kernel;
+typedef Mesh::Face_iterator           Face_iterator;
+typedef Delaunay_mesher<Mesh>         Mesher;
+
+static double linear(Point2 const& p)
+{
+    return 1.0 + 2.0*p.x() - 3.0*p.y();
+}
+
+BOOST_AUTO_TEST_CASE(bilinear_interpolation)
+{
+    Background_grid grid(Bounding_box(Point2(-1.0, 0.0), Point2(1.0, 2.0)), 5, 9);
+    grid.sample(linear);
+    BOOST_CHECK_CLOSE(grid(Point2(0.0, 1.0)), linear(Point2(0.0, 1.0)), 1e-10);
+    BOOST_CHECK_CLOSE(grid(Point2(0.3, 0.7)), linear(Point2(0.3, 0.7)), 1e-10);
+    BOOST_CHECK_CLOSE(grid(Point2(1.0, 2.0)), linear(Point2(1.0, 2.0)), 1e-10);
+    BOOST_CHECK_CLOSE(grid(Point2(-1.0, 0.0)), linear(Point2(-1.0, 0.0)), 1e-10);
+    // points outside of the grid are clamped to it
+    BOOST_CHECK_CLOSE(grid(Point2(3.0, 0.5)), linear(Point2(1.0, 0.5)), 1e-10);
+    BOOST_CHECK_CLOSE(grid(Point2(-2.0, -1.0)), linear(Point2(-1.0, 0.0)), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(gradient_limiting)
+{
+    Background_grid grid(Bounding_box(Point2(0.0, 0.0), Point2(1.0, 1.0)), 21, 21, 0.01);
+    grid.value(10, 10) = 1e-6;
+    grid.limit_gradient(0.5);
+
+    double length_per_area = 4.0/std::sqrt(3.0);
+    BOOST_CHECK_EQUAL(grid.value(10, 10), 1e-6);
+    BOOST_CHECK(grid.value(11, 10) < 0.01);
+    BOOST_CHECK_EQUAL(grid.value(0, 0), 0.01);
+    for (int j = 0; j < grid.ny(); ++j) {
+        for (int i = 0; i + 1 < grid.nx(); ++i) {
+            double h1 = std::sqrt(length_per_area*grid.value(i, j));
+            double h2 = std::sqrt(length_per_area*grid.value(i+1, j));
+            BOOST_CHECK(std::abs(h1 - h2) <= 0.5*0.05*(1.0 + 1e-10));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(refine_with_background_grid)
+{
+    Background_grid grid(Bounding_box(Point2(0.0, 0.0), Point2(1.0, 1.0)), 11, 11, 0.01);
+    grid.value(0, 0) = 0.0001;
+    grid.limit_gradient(0.2);
+
+    Mesh mesh;
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(Polygon::square(1.0), mesh);
+    mesh.make_cdt();
+    Mesher mesher;
+    mesher.set_sizing_field(boost::cref(grid));
+    mesher.refine(mesh, 1.0, 25.0);
+
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(iter->area() <= grid(Kernel::barycenter(p1, p2, p3)));
+    }
+}
@@ -0,0 +1,694 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#define BOOST_TEST_MODULE Delaunay_mesher
+#include <boost/test/unit_test.hpp>
+
+#include "Coordinate_normalization.h"
+#include "Delaunay_mesher.h"
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Domain_decomposition_mesher.h"
+#include "Local_feature_size.h"
+#include "Parallel_delaunay_mesher.h"
+#include "Polygon.h"
+#include "Quality_statistics.h"
+#include "Smoother.h"
+#include "Triangulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace umeshu;
+
+typedef Delaunay_triangulation<Delaunay_triangulation_items> Mesh;
+typedef Mesh::Kernel                  Kernel;
+typedef Mesh::Halfedge_handle         Halfedge_handle;
+typedef Mesh::Edge_iterator           Edge_iterator;
+typedef Mesh::Face_iterator           Face_iterator;
+typedef Delaunay_mesher<Mesh>         Mesher;
+typedef Parallel_delaunay_mesher<Mesh> Parallel_mesher;
+typedef Domain_decomposition_mesher<Mesh> Decomposition_mesher;
+
+static void make_cdt(Polygon const& poly, Mesh& mesh)
+{
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(poly, mesh);
+    mesh.make_cdt();
+}
+
+static void check_mesh(Mesh& mesh, double max_area, size_t number_of_holes = 0)
+{
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Halfedge_handle he = iter->halfedge();
+        BOOST_CHECK(he->next()->next()->next() == he);
+        BOOST_CHECK(he->face() == iter && he->next()->face() == iter && he->prev()->face() == iter);
+        BOOST_CHECK(he->next()->origin() == he->pair()->origin());
+        BOOST_CHECK(he->next()->prev() == he);
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(Kernel::oriented_side(p1, p2, p3) == Kernel::ON_POSITIVE_SIDE);
+        BOOST_CHECK_CLOSE(iter->area(), Kernel::signed_area(p1, p2, p3), 1e-8);
+        BOOST_CHECK(iter->area() <= max_area);
+    }
+    // Euler's formula for a triangulation of a disk with holes
+    BOOST_CHECK_EQUAL(mesh.number_of_nodes() - mesh.number_of_edges() + mesh.number_of_faces() + number_of_holes, 1u);
+    for (Edge_iterator iter = mesh.edges_begin(); iter != mesh.edges_end(); ++iter) {
+        BOOST_CHECK(iter->is_delaunay());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(refine_kidney)
+{
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Mesher mesher;
+    mesher.refine(mesh, 0.001, 21.0);
+    check_mesh(mesh, 0.001);
+
+    Quality_statistics quality = quality_statistics(mesh);
+    BOOST_CHECK_EQUAL(quality.number_of_faces, mesh.number_of_faces());
+    BOOST_CHECK(quality.minimum_angle >= 21.0 - 1e-8);
+    BOOST_CHECK(quality.mean_minimum_angle >= quality.minimum_angle);
+    BOOST_CHECK(quality.longest_edge*quality.longest_edge <= 4.0*0.001);
+    BOOST_CHECK(quality.shortest_edge > 0.0 && quality.shortest_edge < quality.longest_edge);
+}
+
+BOOST_AUTO_TEST_CASE(refine_letter_a)
+{
+    Mesh mesh;
+    make_cdt(Polygon::letter_a(), mesh);
+    Mesher mesher;
+    mesher.refine(mesh, 0.01, 25.0);
+    check_mesh(mesh, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(cached_quality_follows_flips)
+{
+    Mesh mesh;
+    make_cdt(Polygon::square(1.0), mesh);
+    Mesher mesher;
+    mesher.refine(mesh, 0.05, 20.0);
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        iter->area();
+    }
+    for (Edge_iterator iter = mesh.edges_begin(); iter != mesh.edges_end(); ++iter) {
+        if (iter->is_flippable()) {
+            iter->flip();
+        }
+    }
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK_CLOSE(iter->area(), Kernel::signed_area(p1, p2, p3), 1e-8);
+    }
+}
+
+static void check_cached_quality(Mesh& mesh)
+{
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        double a1, a2, a3;
+        Kernel::triangle_angles(p1, p2, p3, a1, a2, a3);
+        double sine = std::sin(std::min(a1, std::min(a2, a3)));
+        BOOST_CHECK_CLOSE(iter->area(), Kernel::signed_area(p1, p2, p3), 1e-8);
+        BOOST_CHECK_CLOSE(iter->min_angle_sine_squared(), sine*sine, 1e-6);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cached_quality_follows_smoothing)
+{
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Mesher mesher;
+    mesher.refine(mesh, 0.001, 25.0);
+    check_cached_quality(mesh);
+
+    Smoother<Mesh> smoother;
+    smoother.smooth(mesh, 3);
+    check_cached_quality(mesh);
+
+    mesh.make_cdt();
+    mesher.refine(mesh, 0.0005, 25.0);
+    check_mesh(mesh, 0.0005);
+    check_cached_quality(mesh);
+}
+
+BOOST_AUTO_TEST_CASE(refine_with_offcenters)
+{
+    Mesh mesh1, mesh2;
+    make_cdt(Polygon::kidney(), mesh1);
+    make_cdt(Polygon::kidney(), mesh2);
+    Mesher mesher1, mesher2;
+    mesher2.set_steiner_point(Mesher::OFFCENTER);
+    mesher1.refine(mesh1, 1.0, 33.0);
+    mesher2.refine(mesh2, 1.0, 33.0);
+    check_mesh(mesh2, 1.0);
+    BOOST_TEST_MESSAGE("circumcenters: " << mesh1.number_of_nodes() << " nodes, off-centers: " << mesh2.number_of_nodes() << " nodes");
+    BOOST_CHECK(mesh2.number_of_nodes() <= mesh1.number_of_nodes());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_refine)
+{
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Parallel_mesher mesher(4);
+    mesher.set_faces_per_thread(16);
+    mesher.refine(mesh, 0.0005, 25.0);
+    check_mesh(mesh, 0.0005);
+    BOOST_CHECK(mesher.concurrent_insertions() > 0);
+
+    // the threads of the mesher are reused
+    Mesh square;
+    make_cdt(Polygon::square(1.0), square);
+    mesher.refine(square, 0.001, 25.0);
+    check_mesh(square, 0.001);
+    BOOST_CHECK(mesher.concurrent_insertions() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(refine_by_domain_decomposition)
+{
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Decomposition_mesher mesher(4);
+    mesher.refine(mesh, 0.0005, 25.0);
+    check_mesh(mesh, 0.0005);
+
+    // three parts meet at nodes inside the domain and the holes touch
+    // several parts
+    Mesh plate;
+    make_cdt(Polygon::plate_with_holes(), plate);
+    Decomposition_mesher plate_mesher(3);
+    plate_mesher.refine(plate, 0.01, 25.0);
+    check_mesh(plate, 0.01, Polygon::plate_with_holes().number_of_holes());
+
+    // the repair along the separators leaves no bad faces anywhere
+    size_t number_of_nodes = mesh.number_of_nodes();
+    Mesher serial;
+    serial.refine(mesh, 0.0005, 25.0);
+    BOOST_CHECK_EQUAL(mesh.number_of_nodes(), number_of_nodes);
+    number_of_nodes = plate.number_of_nodes();
+    serial.refine(plate, 0.01, 25.0);
+    BOOST_CHECK_EQUAL(plate.number_of_nodes(), number_of_nodes);
+}
+
+static double graded_sizing(Point2 const& p)
+{
+    return 0.0002 + 0.01*(p.x()*p.x() + p.y()*p.y());
+}
+
+BOOST_AUTO_TEST_CASE(refine_with_sizing_field)
+{
+    Mesh uniform;
+    make_cdt(Polygon::square(1.0), uniform);
+    Mesher uniform_mesher;
+    uniform_mesher.refine(uniform, 0.0002, 25.0);
+
+    Mesh graded;
+    make_cdt(Polygon::square(1.0), graded);
+    Mesher mesher;
+    mesher.set_sizing_field(graded_sizing);
+    mesher.refine(graded, 1.0, 25.0);
+    check_mesh(graded, 1.0);
+    for (Face_iterator iter = graded.faces_begin(); iter != graded.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(iter->area() <= graded_sizing(Kernel::barycenter(p1, p2, p3)));
+    }
+    BOOST_TEST_MESSAGE("uniform: " << uniform.number_of_nodes() << " nodes, graded: " << graded.number_of_nodes() << " nodes");
+    BOOST_CHECK(2*graded.number_of_nodes() < uniform.number_of_nodes());
+
+    Mesh decomposed;
+    make_cdt(Polygon::square(1.0), decomposed);
+    Decomposition_mesher decomposition_mesher(4);
+    decomposition_mesher.set_sizing_field(graded_sizing);
+    decomposition_mesher.refine(decomposed, 1.0, 25.0);
+    check_mesh(decomposed, 1.0);
+    for (Face_iterator iter = decomposed.faces_begin(); iter != decomposed.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(iter->area() <= graded_sizing(Kernel::barycenter(p1, p2, p3)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(refine_with_automatic_sizing)
+{
+    Local_feature_size<Mesh> lfs(Polygon::coastline());
+    Background_grid grid = lfs.sizing_grid(2.0, 0.5);
+    double min_area = grid(Polygon::coastline().vertices_begin()[0]);
+    for (int j = 0; j < grid.ny(); ++j) {
+        for (int i = 0; i < grid.nx(); ++i) {
+            min_area = std::min(min_area, grid.value(i, j));
+        }
+    }
+
+    Mesh automatic;
+    make_cdt(Polygon::coastline(), automatic);
+    Mesher mesher;
+    mesher.set_automatic_sizing(Polygon::coastline());
+    mesher.refine(automatic, 1.0, 25.0);
+    check_mesh(automatic, 1.0);
+
+    // a single bound fine enough for the narrowest feature
+    Mesh uniform;
+    make_cdt(Polygon::coastline(), uniform);
+    Mesher uniform_mesher;
+    uniform_mesher.refine(uniform, min_area, 25.0);
+
+    BOOST_TEST_MESSAGE("uniform: " << uniform.number_of_nodes() << " nodes, automatic: " << automatic.number_of_nodes() << " nodes");
+    BOOST_CHECK(4*automatic.number_of_nodes() < uniform.number_of_nodes());
+}
+
+BOOST_AUTO_TEST_CASE(refine_to_node_budget)
+{
+    double max_face_area[2];
+    size_t budgets[2] = {300, 1200};
+    for (int k = 0; k < 2; ++k) {
+        Mesh mesh;
+        make_cdt(Polygon::kidney(), mesh);
+        Mesher mesher;
+        mesher.refine_to_node_budget(mesh, budgets[k], 25.0);
+        check_mesh(mesh, 1.0);
+        BOOST_CHECK(mesh.number_of_nodes() >= budgets[k]);
+        BOOST_CHECK(mesh.number_of_nodes() < budgets[k] + 10);
+        max_face_area[k] = 0.0;
+        for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+            max_face_area[k] = std::max(max_face_area[k], iter->area());
+        }
+    }
+    BOOST_CHECK(max_face_area[1] < 0.5*max_face_area[0]);
+
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Parallel_mesher mesher(4);
+    mesher.refine_to_node_budget(mesh, 300, 25.0);
+    check_mesh(mesh, 1.0);
+    BOOST_CHECK(mesh.number_of_nodes() >= 300 && mesh.number_of_nodes() < 310);
+}
+
+struct Progress_recorder {
+    Progress_recorder(std::vector<Mesher::Progress>& reports, size_t stop_after)
+        : reports_(reports), stop_after_(stop_after) {}
+    bool operator()(Mesher::Progress const& progress) {
+        reports_.push_back(progress);
+        return progress.inserted_nodes < stop_after_;
+    }
+    std::vector<Mesher::Progress>& reports_;
+    size_t stop_after_;
+};
+
+BOOST_AUTO_TEST_CASE(progress_and_cancellation)
+{
+    std::vector<Mesher::Progress> reports;
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    size_t initial_nodes = mesh.number_of_nodes();
+    Mesher mesher;
+    mesher.set_progress_callback(Progress_recorder(reports, 1000), 50);
+    mesher.refine(mesh, 0.00001, 25.0);
+
+    // stopped at the first report after 1000 inserted nodes with a valid mesh
+    BOOST_REQUIRE(not reports.empty());
+    BOOST_CHECK(reports.back().inserted_nodes >= 1000);
+    BOOST_CHECK(reports.back().bad_faces > 0);
+    BOOST_CHECK_EQUAL(reports.back().number_of_nodes, mesh.number_of_nodes());
+    BOOST_CHECK_EQUAL(mesh.number_of_nodes() - initial_nodes, reports.back().inserted_nodes);
+    for (size_t i = 1; i < reports.size(); ++i) {
+        BOOST_CHECK(reports[i].inserted_nodes >= reports[i-1].inserted_nodes);
+        BOOST_CHECK(reports[i].elapsed_seconds >= reports[i-1].elapsed_seconds);
+    }
+    check_mesh(mesh, 1.0);
+
+    // a tiny time limit also leaves a valid mesh
+    Mesh limited;
+    make_cdt(Polygon::kidney(), limited);
+    Mesher limited_mesher;
+    limited_mesher.set_time_limit(1e-6);
+    limited_mesher.refine(limited, 0.00001, 25.0);
+    BOOST_CHECK(limited.number_of_nodes() < mesh.number_of_nodes());
+    check_mesh(limited, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(refinement_statistics)
+{
+    Mesh mesh;
+    make_cdt(Polygon::letter_a(), mesh);
+    size_t initial_nodes = mesh.number_of_nodes();
+    Mesher mesher;
+    mesher.set_timing(true);
+    mesher.refine(mesh, 0.001, 25.0);
+    check_mesh(mesh, 0.001);
+
+    Mesher::Statistics const& s = mesher.statistics();
+    BOOST_CHECK_EQUAL(mesh.number_of_nodes() - initial_nodes, s.steiner_points + s.edge_splits);
+    BOOST_CHECK(s.steiner_points > 0);
+    BOOST_CHECK(s.edge_splits > 0);
+    BOOST_CHECK(s.flips > 0);
+    BOOST_CHECK(s.rejected_points > 0);
+    BOOST_CHECK(s.locate_steps >= s.steiner_points + s.rejected_points);
+    BOOST_CHECK(s.incircle_tests > s.steiner_points);
+    BOOST_CHECK(s.enqueued_faces >= s.dequeued_faces);
+    BOOST_CHECK(s.dequeued_faces > 0);
+    BOOST_CHECK(s.insertion_seconds > 0.0);
+    BOOST_CHECK(s.insertion_seconds + s.locate_seconds + s.cavity_seconds > s.splitting_seconds);
+
+    // the statistics are reset by every refinement and timing is off by default
+    Mesh other;
+    make_cdt(Polygon::letter_a(), other);
+    initial_nodes = other.number_of_nodes();
+    Parallel_mesher parallel_mesher(4);
+    parallel_mesher.refine(other, 0.001, 25.0);
+    Mesher::Statistics const& ps = parallel_mesher.statistics();
+    BOOST_CHECK_EQUAL(other.number_of_nodes() - initial_nodes, ps.steiner_points + ps.edge_splits);
+    BOOST_CHECK_EQUAL(ps.insertion_seconds, 0.0);
+    BOOST_CHECK_EQUAL(ps.locate_seconds, 0.0);
+}
+
+struct Half_plane_target {
+    Half_plane_target(double x, double left, double right) : x_(x), left_(left), right_(right) {}
+    double operator()(Mesh::Face_handle f) const {
+        Point2 p1, p2, p3;
+        f->vertices(p1, p2, p3);
+        return p1.x() + p2.x() + p3.x() < 3.0*x_ ? left_ : right_;
+    }
+    double x_, left_, right_;
+};
+
+static size_t count_nodes_left (Mesh const& mesh, double x)
+{
+    size_t n = 0;
+    for (Mesh::Node_const_iterator iter = mesh.nodes_begin(); iter != mesh.nodes_end(); ++iter) {
+        if (iter->position().x() < x) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+BOOST_AUTO_TEST_CASE(adapt_to_face_targets)
+{
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Mesher mesher;
+    mesher.refine(mesh, 0.001, 25.0);
+    size_t uniform_nodes = mesh.number_of_nodes();
+    size_t uniform_left = count_nodes_left(mesh, 1.6);
+
+    // finer on the left, coarser on the right
+    mesher.adapt(mesh, Half_plane_target(1.6, 0.00025, 0.004), 25.0);
+    check_mesh(mesh, 0.004);
+    BOOST_CHECK(mesher.statistics().removed_nodes > 0);
+    BOOST_CHECK(mesher.statistics().steiner_points > 0);
+    BOOST_CHECK(count_nodes_left(mesh, 1.6) > 2*uniform_left);
+    BOOST_CHECK(mesh.number_of_nodes() - count_nodes_left(mesh, 1.6) < uniform_nodes - uniform_left);
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        if (std::max(p1.x(), std::max(p2.x(), p3.x())) < 1.5) {
+            BOOST_CHECK(iter->area() <= 0.00025);
+        }
+    }
+
+    // the other way round
+    mesher.adapt(mesh, Half_plane_target(1.6, 0.004, 0.00025), 25.0);
+    check_mesh(mesh, 0.004);
+    BOOST_CHECK(mesher.statistics().removed_nodes > 0);
+    BOOST_CHECK(count_nodes_left(mesh, 1.6) < uniform_left);
+}
+
+// Half_plane_target with a finer disk, which counts its evaluations
+struct Disk_target {
+    Disk_target(Half_plane_target const& outside, Point2 const& center, double radius, double inside, size_t* evaluations)
+        : outside_(outside), center_(center), radius_(radius), inside_(inside), evaluations_(evaluations) {}
+    double operator()(Mesh::Face_handle f) const {
+        ++*evaluations_;
+        return is_inside(f) ? inside_ : outside_(f);
+    }
+    bool is_inside(Mesh::Face_handle f) const {
+        Point2 p1, p2, p3;
+        f->vertices(p1, p2, p3);
+        return Kernel::distance(Kernel::barycenter(p1, p2, p3), center_) < radius_;
+    }
+    Half_plane_target outside_;
+    Point2 center_;
+    double radius_, inside_;
+    size_t* evaluations_;
+};
+
+BOOST_AUTO_TEST_CASE(adapt_to_local_target_changes)
+{
+    Mesh mesh;
+    make_cdt(Polygon::kidney(), mesh);
+    Mesher mesher;
+    mesher.refine(mesh, 0.001, 25.0);
+    Half_plane_target half_plane(1.6, 0.00025, 0.004);
+    mesher.adapt(mesh, half_plane, 25.0);
+
+    size_t evaluations = 0;
+    Disk_target disk(half_plane, Point2(1.8, 1.0), 0.2, 0.00025, &evaluations);
+    Mesher::Faces changed;
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        if (disk.is_inside(iter)) {
+            changed.push_back(iter);
+        }
+    }
+    BOOST_CHECK(not changed.empty());
+    size_t number_of_faces = mesh.number_of_faces();
+    size_t nodes_left = count_nodes_left(mesh, 1.5);
+    mesher.adapt(mesh, changed, disk, 25.0);
+    check_mesh(mesh, 0.004);
+    BOOST_CHECK(mesher.statistics().steiner_points > 0);
+    // only the faces around the changed ones are evaluated
+    BOOST_CHECK(evaluations < 10*changed.size());
+    BOOST_CHECK(evaluations < number_of_faces/4);
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        Point2 center(1.8, 1.0);
+        if (Kernel::distance(p1, center) < 0.1 && Kernel::distance(p2, center) < 0.1 && Kernel::distance(p3, center) < 0.1) {
+            BOOST_CHECK(iter->area() <= 0.00025);
+        }
+    }
+    // the nodes away from the disk are left alone
+    BOOST_CHECK_EQUAL(count_nodes_left(mesh, 1.5), nodes_left);
+}
+
+// a lake and a strip separated from the rest of the domain by constrained
+// edges
+static Point2 const lake[4] = {Point2(0.213, 0.187), Point2(0.431, 0.205), Point2(0.419, 0.403), Point2(0.197, 0.389)};
+static Point2 const strip_bottom(0.687, 0.011), strip_top(0.693, 0.995);
+
+static void make_regions(Mesh& mesh)
+{
+    Polygon poly;
+    poly.append_vertex(Point2(0.0, 0.0));
+    poly.append_vertex(strip_bottom);
+    poly.append_vertex(Point2(1.03, 0.02));
+    poly.append_vertex(Point2(0.98, 1.01));
+    poly.append_vertex(strip_top);
+    poly.append_vertex(Point2(0.01, 0.97));
+
+    make_cdt(poly, mesh);
+    for (int i = 0; i < 4; ++i) {
+        mesh.insert_constraint(lake[i], lake[(i+1)%4]);
+    }
+    mesh.insert_constraint(strip_bottom, strip_top);
+    mesh.make_cdt();
+    mesh.mark_region(Point2(0.31, 0.27), 2);
+    mesh.mark_region(Point2(0.83, 0.47), 1);
+}
+
+static void check_regions(Mesh& mesh)
+{
+    check_mesh(mesh, 0.005);
+
+    size_t faces_in_region[3] = {0, 0, 0};
+    double max_area[3] = {0.005, 0.0002, 0.00005};
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        Point2 c = Kernel::barycenter(p1, p2, p3);
+        int region = 0;
+        if (Kernel::oriented_side(strip_bottom, strip_top, c) == Kernel::ON_NEGATIVE_SIDE) {
+            region = 1;
+        } else if (Kernel::oriented_side(lake[0], lake[1], c) == Kernel::ON_POSITIVE_SIDE &&
+                   Kernel::oriented_side(lake[1], lake[2], c) == Kernel::ON_POSITIVE_SIDE &&
+                   Kernel::oriented_side(lake[2], lake[3], c) == Kernel::ON_POSITIVE_SIDE &&
+                   Kernel::oriented_side(lake[3], lake[0], c) == Kernel::ON_POSITIVE_SIDE) {
+            region = 2;
+        }
+        BOOST_CHECK_EQUAL(iter->region(), region);
+        BOOST_CHECK(iter->area() <= max_area[iter->region()]);
+        ++faces_in_region[iter->region()];
+    }
+    BOOST_CHECK(faces_in_region[1] > 0.31/0.0002);
+    BOOST_CHECK(faces_in_region[2] > 0.041/0.00005);
+    BOOST_CHECK(faces_in_region[0] < 0.62/0.0002);
+
+    // the constrained edges were split but not flipped away
+    double constrained_length = 0.0;
+    for (Edge_iterator iter = mesh.edges_begin(); iter != mesh.edges_end(); ++iter) {
+        if (iter->is_constrained() && not iter->is_boundary()) {
+            constrained_length += iter->length();
+        }
+    }
+    double expected_length = Kernel::distance(strip_bottom, strip_top);
+    for (int i = 0; i < 4; ++i) {
+        expected_length += Kernel::distance(lake[i], lake[(i+1)%4]);
+    }
+    BOOST_CHECK_CLOSE(constrained_length, expected_length, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(refine_regions)
+{
+    Mesh mesh;
+    make_regions(mesh);
+    BOOST_CHECK_THROW(mesh.mark_region(Point2(2.0, 0.5), 1), Mesh::region_error);
+
+    Mesher mesher;
+    mesher.set_region_max_area(1, 0.0002);
+    mesher.set_region_max_area(2, 0.00005);
+    mesher.refine(mesh, 0.005, 25.0);
+    check_regions(mesh);
+}
+
+BOOST_AUTO_TEST_CASE(refine_regions_by_domain_decomposition)
+{
+    Mesh mesh;
+    make_regions(mesh);
+    Decomposition_mesher mesher(4);
+    mesher.set_region_max_area(1, 0.0002);
+    mesher.set_region_max_area(2, 0.00005);
+    mesher.refine(mesh, 0.005, 25.0);
+    check_regions(mesh);
+}
+
+static bool point_is_in_polygon(Point2 const& p, Polygon const& poly)
+{
+    bool inside = false;
+    size_t n = poly.number_of_vertices();
+    for (size_t i = 0; i < n; ++i) {
+        Point2 const& a = poly.vertices_begin()[i];
+        Point2 const& b = poly.vertices_begin()[(i+1) % n];
+        if ((a.y() > p.y()) != (b.y() > p.y()) &&
+            p.x() < a.x() + (p.y() - a.y())*(b.x() - a.x())/(b.y() - a.y())) {
+            inside = not inside;
+        }
+    }
+    return inside;
+}
+
+static void check_holes(Mesh& mesh, Polygon const& poly)
+{
+    double area = 0.0;
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        Point2 c = Kernel::barycenter(p1, p2, p3);
+        BOOST_CHECK(point_is_in_polygon(c, poly));
+        for (Polygon::hole_const_iterator hole = poly.holes_begin(); hole != poly.holes_end(); ++hole) {
+            BOOST_CHECK(not point_is_in_polygon(c, *hole));
+        }
+        area += iter->area();
+    }
+    double expected_area = std::abs(poly.signed_area());
+    for (Polygon::hole_const_iterator hole = poly.holes_begin(); hole != poly.holes_end(); ++hole) {
+        expected_area -= std::abs(hole->signed_area());
+    }
+    BOOST_CHECK_CLOSE(area, expected_area, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(refine_polygon_with_holes)
+{
+    Polygon poly = Polygon::plate_with_holes();
+
+    // one hole is given clockwise
+    Polygon hole;
+    hole.append_vertex(Point2(0.31, 0.61));
+    hole.append_vertex(Point2(0.23, 0.83));
+    hole.append_vertex(Point2(0.41, 0.79));
+    poly.add_hole(hole);
+
+    Mesh mesh;
+    make_cdt(poly, mesh);
+    BOOST_CHECK_EQUAL(mesh.number_of_nodes(), 18u);
+    check_mesh(mesh, 1.0, 4);
+    check_holes(mesh, poly);
+
+    Mesher mesher;
+    mesher.refine(mesh, 0.002, 25.0);
+    check_mesh(mesh, 0.002, 4);
+    check_holes(mesh, poly);
+
+    // the automatic sizing resolves the narrow gaps between the holes
+    Mesh graded;
+    make_cdt(poly, graded);
+    mesher.set_automatic_sizing(poly);
+    mesher.refine(graded, 0.01, 25.0);
+    check_mesh(graded, 0.01, 4);
+    check_holes(graded, poly);
+
+    Polygon degenerate = Polygon::plate_with_holes();
+    Polygon segment;
+    segment.append_vertex(Point2(0.5, 0.5));
+    segment.append_vertex(Point2(0.6, 0.5));
+    degenerate.add_hole(segment);
+    Mesh invalid;
+    Triangulator<Mesh> triangulator;
+    BOOST_CHECK_THROW(triangulator.triangulate(degenerate, invalid), Triangulator<Mesh>::triangulator_error);
+}
+
+BOOST_AUTO_TEST_CASE(refine_in_normalized_coordinates)
+{
+    // the kidney in metres at projected map coordinates
+    Polygon kidney = Polygon::kidney();
+    Polygon boundary;
+    for (Polygon::vertex_const_iterator iter = kidney.vertices_begin(); iter != kidney.vertices_end(); ++iter) {
+        boundary.append_vertex(Point2(512345.25 + 1000.0*iter->x(), 5412345.5 + 1000.0*iter->y()));
+    }
+    Coordinate_normalization normalization(boundary);
+    Polygon normalized = normalization.normalize(boundary);
+    Bounding_box bb = normalized.bounding_box();
+    BOOST_CHECK(bb.ll().x() >= 0.0 && bb.ll().y() >= 0.0);
+    BOOST_CHECK(bb.ur().x() < 1.0 && bb.ur().y() < 1.0);
+    BOOST_CHECK(std::max(bb.width(), bb.height()) >= 0.5);
+
+    Mesh mesh;
+    make_cdt(normalized, mesh);
+    Mesher mesher;
+    mesher.refine(mesh, normalization.normalize_area(1000.0), 21.0);
+    normalization.denormalize_nodes(mesh);
+    check_mesh(mesh, 1000.0*(1.0 + 1e-12));
+
+    // the vertices of the boundary are recovered exactly
+    size_t found = 0;
+    for (Polygon::vertex_const_iterator iter = boundary.vertices_begin(); iter != boundary.vertices_end(); ++iter) {
+        for (Mesh::Node_iterator node = mesh.nodes_begin(); node != mesh.nodes_end(); ++node) {
+            if (node->position() == *iter) {
+                ++found;
+                break;
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(found, boundary.number_of_vertices());
+}
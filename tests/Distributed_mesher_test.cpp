@@ -0,0 +1,214 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+
+#define BOOST_TEST_MODULE Distributed_mesher
+#include <boost/test/unit_test.hpp>
+
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Distributed_mesher.h"
+#include "Polygon.h"
+#include "Triangulator.h"
+
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/environment.hpp>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace umeshu;
+
+typedef Delaunay_triangulation<Delaunay_triangulation_items> Mesh;
+typedef Mesh::Kernel                  Kernel;
+typedef Mesh::Edge_iterator           Edge_iterator;
+typedef Mesh::Halfedge_handle         Halfedge_handle;
+typedef Mesh::Face_iterator           Face_iterator;
+typedef Distributed_mesher<Mesh>      Mesher;
+
+// run with mpirun -np 4
+struct Mpi_environment {
+    boost::mpi::environment env;
+};
+
+BOOST_GLOBAL_FIXTURE(Mpi_environment);
+
+static void make_cdt(Polygon const& poly, Mesh& mesh)
+{
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(poly, mesh);
+    mesh.make_cdt();
+}
+
+static void check_faces(Mesh& mesh, double max_area)
+{
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(Kernel::oriented_side(p1, p2, p3) == Kernel::ON_POSITIVE_SIDE);
+        BOOST_CHECK(iter->area() <= max_area);
+    }
+}
+
+// Every rank checks that no boundary edge of its subdomain is encroached
+// upon, which makes the subdomains together Delaunay, and sends its
+// boundary edges to rank 0. Edges on the separators come from two ranks
+// with opposite directions, the others make up the domain boundary.
+BOOST_AUTO_TEST_CASE(separators_conform)
+{
+    boost::mpi::communicator world;
+    Mesh mesh;
+    if (world.rank() == 0) {
+        make_cdt(Polygon::kidney(), mesh);
+    }
+    Mesher mesher(world);
+    mesher.refine(mesh, 0.0005, 25.0);
+    BOOST_CHECK(mesh.number_of_faces() > 0);
+    BOOST_CHECK(mesher.rounds() > 0);
+    BOOST_TEST_MESSAGE("rank " << world.rank() << ": " << mesher.rounds() << " rounds, " << mesh.number_of_nodes() << " nodes");
+    check_faces(mesh, 0.0005);
+
+    std::vector<double> boundary;
+    for (Edge_iterator iter = mesh.edges_begin(); iter != mesh.edges_end(); ++iter) {
+        BOOST_CHECK(iter->is_delaunay());
+        if (not iter->is_boundary()) {
+            continue;
+        }
+        Halfedge_handle he = iter->he1()->is_boundary() ? iter->he2() : iter->he1();
+        BOOST_CHECK(not iter->is_encroached_upon(he->prev()->origin()->position()));
+        Point2 p1, p2;
+        he->vertices(p1, p2);
+        boundary.push_back(p1.x());
+        boundary.push_back(p1.y());
+        boundary.push_back(p2.x());
+        boundary.push_back(p2.y());
+    }
+    if (world.rank() != 0) {
+        boost::mpi::gather(world, boundary, 0);
+        return;
+    }
+    std::vector<std::vector<double> > gathered;
+    boost::mpi::gather(world, boundary, gathered, 0);
+    typedef std::pair<double, double> Coordinates;
+    typedef std::map<std::pair<Coordinates, Coordinates>, int> Edge_counts;
+    Edge_counts counts;
+    for (size_t r = 0; r < gathered.size(); ++r) {
+        for (size_t i = 0; i < gathered[r].size(); i += 4) {
+            ++counts[std::make_pair(Coordinates(gathered[r][i], gathered[r][i+1]), Coordinates(gathered[r][i+2], gathered[r][i+3]))];
+        }
+    }
+    double perimeter = 0.0;
+    size_t separator_edges = 0;
+    for (Edge_counts::const_iterator iter = counts.begin(); iter != counts.end(); ++iter) {
+        BOOST_CHECK_EQUAL(iter->second, 1);
+        if (counts.find(std::make_pair(iter->first.second, iter->first.first)) != counts.end()) {
+            ++separator_edges;
+        } else {
+            Point2 p1(iter->first.first.first, iter->first.first.second);
+            Point2 p2(iter->first.second.first, iter->first.second.second);
+            perimeter += Kernel::distance(p1, p2);
+        }
+    }
+    BOOST_CHECK(separator_edges > 0);
+    Polygon kidney = Polygon::kidney();
+    double kidney_perimeter = 0.0;
+    size_t n = kidney.number_of_vertices();
+    for (size_t i = 0; i < n; ++i) {
+        kidney_perimeter += Kernel::distance(kidney.vertices_begin()[i], kidney.vertices_begin()[(i + 1) % n]);
+    }
+    BOOST_CHECK_CLOSE(perimeter, kidney_perimeter, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(subdomains_cover_the_domain)
+{
+    boost::mpi::communicator world;
+    Mesh mesh;
+    if (world.rank() == 0) {
+        make_cdt(Polygon::kidney(), mesh);
+    }
+    Mesher mesher(world);
+    mesher.refine(mesh, 0.0005, 25.0);
+    BOOST_CHECK(mesh.number_of_faces() > 0);
+    check_faces(mesh, 0.0005);
+
+    // the subdomains cover the domain without overlapping
+    double area = 0.0;
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        area += iter->area();
+    }
+    double total_area = boost::mpi::all_reduce(world, area, std::plus<double>());
+    Mesh whole;
+    make_cdt(Polygon::kidney(), whole);
+    double whole_area = 0.0;
+    for (Face_iterator iter = whole.faces_begin(); iter != whole.faces_end(); ++iter) {
+        whole_area += iter->area();
+    }
+    BOOST_CHECK_CLOSE(total_area, whole_area, 1e-8);
+}
+
+// A strip of finer faces behind a constraint across a square keeps its
+// region and its constrained edges on every rank.
+BOOST_AUTO_TEST_CASE(regions_and_constraints_are_distributed)
+{
+    boost::mpi::communicator world;
+    Point2 strip_bottom(0.62, 0.0), strip_top(0.57, 1.0);
+    Mesh mesh;
+    if (world.rank() == 0) {
+        Polygon poly;
+        poly.append_vertex(Point2(0.0, 0.0));
+        poly.append_vertex(strip_bottom);
+        poly.append_vertex(Point2(1.0, 0.0));
+        poly.append_vertex(Point2(1.0, 1.0));
+        poly.append_vertex(strip_top);
+        poly.append_vertex(Point2(0.0, 1.0));
+        make_cdt(poly, mesh);
+        mesh.insert_constraint(strip_bottom, strip_top);
+        mesh.make_cdt();
+        mesh.mark_region(Point2(0.8, 0.5), 1);
+    }
+    Mesher mesher(world);
+    mesher.set_region_max_area(1, 0.0002);
+    mesher.refine(mesh, 0.002, 25.0);
+    check_faces(mesh, 0.002);
+
+    for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        Point2 c = Kernel::barycenter(p1, p2, p3);
+        bool in_strip = Kernel::oriented_side(strip_bottom, strip_top, c) == Kernel::ON_NEGATIVE_SIDE;
+        BOOST_CHECK_EQUAL(iter->region(), in_strip ? 1 : 0);
+        if (in_strip) {
+            BOOST_CHECK(iter->area() <= 0.0002);
+        }
+    }
+
+    // the pieces of the constraint on a separator are seen by both ranks
+    double constrained_length = 0.0;
+    for (Edge_iterator iter = mesh.edges_begin(); iter != mesh.edges_end(); ++iter) {
+        if (iter->is_marked_constrained()) {
+            constrained_length += iter->is_boundary() ? 0.5*iter->length() : iter->length();
+        }
+    }
+    double total_length = boost::mpi::all_reduce(world, constrained_length, std::plus<double>());
+    BOOST_CHECK_CLOSE(total_length, Kernel::distance(strip_bottom, strip_top), 1e-8);
+}
@@ -0,0 +1,280 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+
+
+#define BOOST_TEST_MODULE Kernel
+#include <boost/test/unit_test.hpp>
+
+#include "Delaunay_mesher.h"
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Exact_adaptive_kernel.h"
+#include "Fast_kernel.h"
+#include "Interval_filtered_kernel.h"
+#include "Polygon.h"
+#include "Snap_rounding_kernel.h"
+#include "Triangulator.h"
+
+#include <boost/mpl/list.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace umeshu;
+
+typedef boost::mpl::list<Exact_adaptive_kernel, Interval_filtered_kernel> Exact_kernels;
+typedef boost::mpl::list<Exact_adaptive_kernel, Interval_filtered_kernel, Fast_kernel, Snap_rounding_kernel<20> > All_kernels;
+
+BOOST_AUTO_TEST_CASE(interval_arithmetic)
+{
+    Interval a(-1.0, 2.0), b(3.0, 5.0);
+    Interval c = a*b;
+    BOOST_CHECK(c.lo() <= -5.0 && c.hi() >= 10.0);
+    Interval d = square(a);
+    BOOST_CHECK(d.lo() <= 0.0 && d.hi() >= 4.0);
+    // 0.1 + 0.2 is not representable, the interval must contain it
+    Interval e = Interval(0.1) + Interval(0.2);
+    BOOST_CHECK(e.lo() < 0.1 + 0.2 && e.hi() > 0.1 + 0.2);
+    BOOST_CHECK((Interval(1.0) - Interval(1.0)).lo() < 0.0);
+    BOOST_CHECK(not (Interval(1.0) - Interval(1.0)).is_positive());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(orientation_near_a_line, Kernel, Exact_kernels)
+{
+    // the orientation of p relative to the line through q and r is the sign
+    // of p.y - p.x, which plain floating point gets wrong for most p
+    Point2 q(12.0, 12.0), r(24.0, 24.0);
+    double const ulp = std::ldexp(1.0, -53);
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            Point2 p(0.5 + i*ulp, 0.5 + j*ulp);
+            typename Kernel::Oriented_side expected = j > i ? Kernel::ON_POSITIVE_SIDE :
+                                            (j < i ? Kernel::ON_NEGATIVE_SIDE : Kernel::ON_ORIENTED_BOUNDARY);
+            BOOST_CHECK(Kernel::oriented_side(p, q, r) == expected);
+            BOOST_CHECK(Kernel::oriented_side(q, r, p) == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(incircle_near_a_circle, Kernel, Exact_kernels)
+{
+    // points on the circle of radius 5 centred at (1024.25, 1024.25)
+    double const c = 1024.25;
+    Point2 a(c + 5.0, c), b(c + 3.0, c + 4.0), d(c - 4.0, c - 3.0);
+    Point2 on(c, c + 5.0);
+    Point2 inside(c, std::nextafter(c + 5.0, 0.0));
+    Point2 outside(c, std::nextafter(c + 5.0, 2.0*c));
+    BOOST_CHECK(Kernel::oriented_circle(a, b, d, on) == Kernel::ON_ORIENTED_BOUNDARY);
+    BOOST_CHECK(Kernel::oriented_circle(a, b, d, inside) == Kernel::ON_POSITIVE_SIDE);
+    BOOST_CHECK(Kernel::oriented_circle(a, b, d, outside) == Kernel::ON_NEGATIVE_SIDE);
+    BOOST_CHECK(Kernel::oriented_circle(b, d, a, inside) == Kernel::ON_POSITIVE_SIDE);
+    BOOST_CHECK(Kernel::oriented_circle(b, d, a, outside) == Kernel::ON_NEGATIVE_SIDE);
+}
+
+BOOST_AUTO_TEST_CASE(predicate_statistics)
+{
+    typedef Exact_adaptive_kernel Kernel;
+    Kernel::reset_statistics();
+    Point2 q(12.0, 12.0), r(24.0, 24.0);
+    Kernel::oriented_side(Point2(0.0, 1.0), q, r);
+    Kernel::oriented_side(Point2(0.5, 0.5 + std::ldexp(1.0, -53)), q, r);
+    Predicate_statistics stats = Kernel::statistics();
+    if (Predicate_statistics::enabled()) {
+        BOOST_CHECK_EQUAL(stats.calls(Predicate_statistics::ORIENTATION), 2u);
+        BOOST_CHECK_EQUAL(stats.calls(Predicate_statistics::ORIENTATION, Predicate_statistics::STAGE_A), 1u);
+        BOOST_CHECK_EQUAL(stats.adaptive_calls(Predicate_statistics::ORIENTATION), 1u);
+    } else {
+        BOOST_CHECK_EQUAL(stats.calls(Predicate_statistics::ORIENTATION), 0u);
+    }
+    BOOST_CHECK_EQUAL(stats.calls(Predicate_statistics::INCIRCLE), 0u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(batched_predicates, Kernel, All_kernels)
+{
+    // points near the diagonal, half of which need the exact stages, in a
+    // number that is not a multiple of the vector width
+    size_t const n = 103;
+    double const ulp = std::ldexp(1.0, -53);
+    std::vector<Point2> pa(n), pb(n), pc(n), tests(n);
+    std::srand(2);
+    for (size_t i = 0; i < n; ++i) {
+        double s = 0.25 + (std::rand() % 64)*0.25;
+        pa[i] = Point2(0.5 + (std::rand() % 8)*ulp, 0.5 + (std::rand() % 8)*ulp);
+        pb[i] = Point2(s, s);
+        pc[i] = Point2(-s, s + 1.0);
+        tests[i] = i % 2 ? Point2(2.0*s, 2.0*s) : Point2(std::rand() % 5 - 2.0, std::rand() % 5 - 2.0);
+    }
+
+    std::vector<typename Kernel::Oriented_side> results(n);
+    Kernel::oriented_sides(pa[0], pb[0], &tests[0], n, &results[0]);
+    for (size_t i = 0; i < n; ++i) {
+        BOOST_CHECK(results[i] == Kernel::oriented_side(pa[0], pb[0], tests[i]));
+    }
+    Kernel::oriented_circles(&pa[0], &pb[0], &pc[0], &tests[0], n, &results[0]);
+    for (size_t i = 0; i < n; ++i) {
+        BOOST_CHECK(results[i] == Kernel::oriented_circle(pa[i], pb[i], pc[i], tests[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(batched_constructions, Kernel, All_kernels)
+{
+    size_t const n = 103;
+    std::vector<Point2> p1(n), p2(n), p3(n);
+    std::srand(3);
+    for (size_t i = 0; i < n; ++i) {
+        p1[i] = Point2(std::rand() % 64*0.125, std::rand() % 64*0.125);
+        p2[i] = p1[i] + Point2(1.0 + std::rand() % 16*0.25, std::rand() % 16*0.125);
+        p3[i] = p1[i] + Point2(-(std::rand() % 16)*0.125, 1.0 + std::rand() % 16*0.25);
+    }
+
+    std::vector<double> values(n);
+    Kernel::distances(&p1[0], &p2[0], n, &values[0]);
+    for (size_t i = 0; i < n; ++i) {
+        BOOST_CHECK_CLOSE(values[i], Kernel::distance(p1[i], p2[i]), 1e-12);
+    }
+    std::vector<Point2> centers(n);
+    Kernel::circumcenters(&p1[0], &p2[0], &p3[0], n, &centers[0]);
+    for (size_t i = 0; i < n; ++i) {
+        Point2 c = Kernel::circumcenter(p1[i], p2[i], p3[i]);
+        BOOST_CHECK_SMALL(Kernel::distance(centers[i], c), 1e-5);
+    }
+    Kernel::minimum_angles(&p1[0], &p2[0], &p3[0], n, &values[0]);
+    for (size_t i = 0; i < n; ++i) {
+        double a1, a2, a3;
+        Kernel::triangle_angles(p1[i], p2[i], p3[i], a1, a2, a3);
+        BOOST_CHECK_CLOSE(values[i], std::min(a1, std::min(a2, a3)), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(refine_with_fast_kernel)
+{
+    typedef Delaunay_triangulation<Delaunay_triangulation_items, Fast_kernel> Mesh;
+
+    Mesh mesh;
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(Polygon::kidney(), mesh);
+    mesh.make_cdt();
+    Delaunay_mesher<Mesh> mesher;
+    mesher.refine(mesh, 0.001, 25.0);
+
+    BOOST_CHECK(mesh.number_of_faces() > 1000);
+    for (Mesh::Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(Exact_adaptive_kernel::oriented_side(p1, p2, p3) == Exact_adaptive_kernel::ON_POSITIVE_SIDE);
+        BOOST_CHECK(iter->area() <= 0.001);
+    }
+}
+
+// Boundary vertices far from the origin that are collinear up to one unit
+// in the last place, where the fast kernel misjudges orientations and
+// incircle tests. The result must be either a valid mesh or a
+// topology_error, never a failed assertion or a loop that does not end.
+BOOST_AUTO_TEST_CASE(refine_nearly_degenerate_with_fast_kernel)
+{
+    typedef Delaunay_triangulation<Delaunay_triangulation_items, Fast_kernel> Mesh;
+
+    double const offset = 1e8, ulp = 1.4901161193847656e-8;
+    Polygon poly;
+    for (int i = 0; i <= 100; ++i) {
+        poly.append_vertex(Point2(offset + i/100.0, offset + ((i*7) % 3 - 1)*ulp));
+    }
+    poly.append_vertex(Point2(offset + 0.5, offset + 0.3));
+
+    Mesh mesh;
+    try {
+        Triangulator<Mesh> triangulator;
+        triangulator.triangulate(poly, mesh);
+        mesh.make_cdt();
+        Delaunay_mesher<Mesh> mesher;
+        mesher.refine(mesh, 0.0005, 25.0);
+    }
+    catch (topology_error&) {
+        return;
+    }
+
+    BOOST_CHECK(mesh.number_of_faces() > 0);
+    for (Mesh::Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        Point2 p1, p2, p3;
+        iter->vertices(p1, p2, p3);
+        BOOST_CHECK(Exact_adaptive_kernel::oriented_side(p1, p2, p3) == Exact_adaptive_kernel::ON_POSITIVE_SIDE);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(snap_rounding_predicates)
+{
+    typedef Snap_rounding_kernel<0> Kernel;
+
+    // large cocircular integer points, whose incircle determinant needs
+    // more than 64 bits
+    double const m = 1e7;
+    Point2 a(5*m, 0.0), b(3*m, 4*m), c(-4*m, -3*m);
+    BOOST_CHECK(Kernel::oriented_circle(a, b, c, Point2(0.0, 5*m)) == Kernel::ON_ORIENTED_BOUNDARY);
+    BOOST_CHECK(Kernel::oriented_circle(a, b, c, Point2(0.0, 5*m - 1)) == Kernel::ON_POSITIVE_SIDE);
+    BOOST_CHECK(Kernel::oriented_circle(a, b, c, Point2(0.0, 5*m + 1)) == Kernel::ON_NEGATIVE_SIDE);
+
+    // on grid points, the integer predicates agree with the exact ones
+    std::srand(1);
+    for (int i = 0; i < 10000; ++i) {
+        Point2 p[4];
+        for (int k = 0; k < 4; ++k) {
+            p[k] = Point2(std::rand() % 9 - 4 + (std::rand() % 2)*5e8, std::rand() % 9 - 4 + (std::rand() % 2)*5e8);
+        }
+        BOOST_CHECK(Kernel::oriented_side(p[0], p[1], p[2]) == Exact_adaptive_kernel::oriented_side(p[0], p[1], p[2]));
+        BOOST_CHECK(Kernel::oriented_circle(p[0], p[1], p[2], p[3]) == Exact_adaptive_kernel::oriented_circle(p[0], p[1], p[2], p[3]));
+    }
+
+    BOOST_CHECK(Snap_rounding_kernel<4>::snap(Point2(0.55, -0.55)) == Point2(0.5625, -0.5625));
+    BOOST_CHECK_THROW(Kernel::oriented_side(a, b, Point2(6e8, 0.0)), Kernel::coordinate_range_error);
+}
+
+BOOST_AUTO_TEST_CASE(refine_with_snap_rounding_kernel)
+{
+    typedef Snap_rounding_kernel<16> Kernel;
+    typedef Delaunay_triangulation<Delaunay_triangulation_items, Kernel> Mesh;
+
+    // the vertices of the polygon are snapped when they are added
+    Mesh mesh;
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(Polygon::kidney(), mesh);
+    mesh.make_cdt();
+    Delaunay_mesher<Mesh> mesher;
+    mesher.refine(mesh, 0.001, 25.0);
+
+    BOOST_CHECK(mesh.number_of_faces() > 1000);
+    std::set<std::pair<double, double> > positions;
+    for (Mesh::Node_iterator iter = mesh.nodes_begin(); iter != mesh.nodes_end(); ++iter) {
+        BOOST_CHECK(Kernel::snap(iter->position()) == iter->position());
+        BOOST_CHECK(positions.insert(std::make_pair(iter->position().x(), iter->position().y())).second);
+    }
+    for (Mesh::Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+        BOOST_CHECK(iter->area() > 0.0 && iter->area() <= 0.001);
+    }
+    for (Mesh::Edge_iterator iter = mesh.edges_begin(); iter != mesh.edges_end(); ++iter) {
+        BOOST_CHECK(iter->is_delaunay());
+    }
+}
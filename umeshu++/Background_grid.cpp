@@ -0,0 +1,113 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#include "Background_grid.h"
+
+#include <boost/assert.hpp>
+
+#include <cmath>
+
+namespace umeshu {
+
+Background_grid::Background_grid(Bounding_box const& bb, int nx, int ny, double value)
+: ll_(bb.ll()),
+  nx_(nx),
+  ny_(ny),
+  dx_(bb.width()/(nx - 1)),
+  dy_(bb.height()/(ny - 1)),
+  inv_dx_(1.0/dx_),
+  inv_dy_(1.0/dy_),
+  values_(nx*ny, value)
+{
+    BOOST_ASSERT(nx > 1 && ny > 1);
+}
+
+void Background_grid::limit_gradient(double max_gradient)
+{
+    // the gradient is limited on edge lengths rather than on areas, in
+    // sweeps over the grid in alternating directions until nothing changes
+    double const length_per_area = 4.0/std::sqrt(3.0);
+    std::vector<double> h(values_.size());
+    for (size_t k = 0; k < values_.size(); ++k) {
+        h[k] = std::sqrt(length_per_area*values_[k]);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int j = 0; j < ny_; ++j) {
+            for (int i = 0; i < nx_; ++i) {
+                changed |= relax(h, i, j, max_gradient);
+            }
+        }
+        for (int j = ny_ - 1; j >= 0; --j) {
+            for (int i = nx_ - 1; i >= 0; --i) {
+                changed |= relax(h, i, j, max_gradient);
+            }
+        }
+        for (int j = 0; j < ny_; ++j) {
+            for (int i = nx_ - 1; i >= 0; --i) {
+                changed |= relax(h, i, j, max_gradient);
+            }
+        }
+        for (int j = ny_ - 1; j >= 0; --j) {
+            for (int i = 0; i < nx_; ++i) {
+                changed |= relax(h, i, j, max_gradient);
+            }
+        }
+    }
+
+    // only the lowered values are converted back, so that the others stay
+    // exactly as they were sampled
+    for (size_t k = 0; k < values_.size(); ++k) {
+        if (h[k] < std::sqrt(length_per_area*values_[k])) {
+            values_[k] = h[k]*h[k]/length_per_area;
+        }
+    }
+}
+
+bool Background_grid::relax(std::vector<double>& h, int i, int j, double max_gradient) const
+{
+    double const dxy = std::sqrt(dx_*dx_ + dy_*dy_);
+    double& hij = h[j*nx_ + i];
+    double limited = hij;
+    for (int dj = -1; dj <= 1; ++dj) {
+        for (int di = -1; di <= 1; ++di) {
+            int ii = i + di, jj = j + dj;
+            if ((di == 0 && dj == 0) || ii < 0 || ii >= nx_ || jj < 0 || jj >= ny_) {
+                continue;
+            }
+            double d = di == 0 ? dy_ : (dj == 0 ? dx_ : dxy);
+            double bound = h[jj*nx_ + ii] + max_gradient*d;
+            if (bound < limited) {
+                limited = bound;
+            }
+        }
+    }
+    if (limited < hij) {
+        hij = limited;
+        return true;
+    }
+    return false;
+}
+
+} // namespace umeshu
@@ -0,0 +1,90 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __BACKGROUND_GRID_H_INCLUDED__
+#define __BACKGROUND_GRID_H_INCLUDED__
+
+#include "Bounding_box.h"
+#include "Point2.h"
+
+#include <vector>
+
+namespace umeshu {
+
+// Sizing field sampled at the nodes of a regular grid and interpolated
+// bilinearly in between. Points outside of the grid take the value at the
+// nearest point of the grid. The values are maximum face areas, so the grid
+// can be passed to Delaunay_mesher::set_sizing_field, preferably wrapped in
+// boost::cref to avoid copying it.
+class Background_grid {
+public:
+    Background_grid(Bounding_box const& bb, int nx, int ny, double value = 0.0);
+
+    int nx() const { return nx_; }
+    int ny() const { return ny_; }
+
+    Point2 node(int i, int j) const {
+        return Point2(ll_.x() + i*dx_, ll_.y() + j*dy_);
+    }
+
+    double& value(int i, int j)       { return values_[j*nx_ + i]; }
+    double  value(int i, int j) const { return values_[j*nx_ + i]; }
+
+    template <typename Function>
+    void sample(Function f) {
+        for (int j = 0; j < ny_; ++j) {
+            for (int i = 0; i < nx_; ++i) {
+                value(i, j) = f(node(i, j));
+            }
+        }
+    }
+
+    // Lowers the values so that the edge lengths of equilateral triangles
+    // of the given areas grow by at most max_gradient per unit distance
+    // between the nodes of the grid.
+    void limit_gradient(double max_gradient);
+
+    double operator()(Point2 const& p) const {
+        double s = (p.x() - ll_.x())*inv_dx_;
+        double t = (p.y() - ll_.y())*inv_dy_;
+        s = s < 0.0 ? 0.0 : (s > nx_ - 1 ? nx_ - 1 : s);
+        t = t < 0.0 ? 0.0 : (t > ny_ - 1 ? ny_ - 1 : t);
+        int i = s < nx_ - 1 ? static_cast<int>(s) : nx_ - 2;
+        int j = t < ny_ - 1 ? static_cast<int>(t) : ny_ - 2;
+        s -= i;
+        t -= j;
+        double const* v = &values_[j*nx_ + i];
+        return (1.0 - t)*((1.0 - s)*v[0] + s*v[1]) + t*((1.0 - s)*v[nx_] + s*v[nx_ + 1]);
+    }
+
+private:
+    bool relax(std::vector<double>& h, int i, int j, double max_gradient) const;
+
+    Point2              ll_;
+    int                 nx_, ny_;
+    double              dx_, dy_, inv_dx_, inv_dy_;
+    std::vector<double> values_;
+};
+
+} // namespace umeshu
+
+#endif // __BACKGROUND_GRID_H_INCLUDED__
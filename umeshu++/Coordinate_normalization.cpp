@@ -0,0 +1,69 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "Coordinate_normalization.h"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace umeshu {
+
+Coordinate_normalization::Coordinate_normalization()
+: origin_(0.0, 0.0), scale_(1.0)
+{}
+
+Coordinate_normalization::Coordinate_normalization(Bounding_box const& bb)
+{
+    init(bb);
+}
+
+Coordinate_normalization::Coordinate_normalization(Polygon const& poly)
+{
+    // the holes lie inside of the outer boundary
+    init(poly.bounding_box());
+}
+
+void Coordinate_normalization::init(Bounding_box const& bb)
+{
+    double extent = std::max(bb.width(), bb.height());
+    BOOST_ASSERT(extent > 0.0);
+    // the smallest power of two that is larger than the extent
+    int exponent;
+    std::frexp(extent, &exponent);
+    origin_ = bb.ll();
+    scale_ = std::ldexp(1.0, exponent);
+}
+
+Polygon Coordinate_normalization::normalize(Polygon const& poly) const
+{
+    Polygon normalized;
+    for (Polygon::vertex_const_iterator iter = poly.vertices_begin(); iter != poly.vertices_end(); ++iter) {
+        normalized.append_vertex(normalize(*iter));
+    }
+    for (Polygon::hole_const_iterator iter = poly.holes_begin(); iter != poly.holes_end(); ++iter) {
+        normalized.add_hole(normalize(*iter));
+    }
+    return normalized;
+}
+
+} // namespace umeshu
@@ -0,0 +1,84 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef __COORDINATE_NORMALIZATION_H_INCLUDED__
+#define __COORDINATE_NORMALIZATION_H_INCLUDED__
+
+#include "Bounding_box.h"
+#include "Point2.h"
+#include "Polygon.h"
+
+namespace umeshu {
+
+// Translates and scales the coordinates of a domain into the unit box
+// [0,1)x[0,1). Far from the origin, e.g. with projected map coordinates in
+// the millions, the floating-point filters of the predicates fail much more
+// often and the mesh loses precision; meshing the normalized polygon and
+// mapping the nodes back avoids both. The scale is a power of two, so the
+// vertices of the input are usually recovered exactly.
+class Coordinate_normalization {
+public:
+    // the identity
+    Coordinate_normalization();
+    explicit Coordinate_normalization(Bounding_box const& bb);
+    explicit Coordinate_normalization(Polygon const& poly);
+
+    Point2 normalize(Point2 const& p) const {
+        return Point2((p.x() - origin_.x())/scale_, (p.y() - origin_.y())/scale_);
+    }
+
+    Point2 denormalize(Point2 const& p) const {
+        return Point2(origin_.x() + p.x()*scale_, origin_.y() + p.y()*scale_);
+    }
+
+    // the polygon including its holes
+    Polygon normalize(Polygon const& poly) const;
+
+    double normalize_length  (double l) const { return l/scale_; }
+    double normalize_area    (double a) const { return a/(scale_*scale_); }
+    double denormalize_length(double l) const { return l*scale_; }
+    double denormalize_area  (double a) const { return a*scale_*scale_; }
+
+    // Maps the nodes of a Delaunay triangulation built in the normalized
+    // coordinates back and invalidates the quality cached in its faces.
+    template <typename Triangulation>
+    void denormalize_nodes(Triangulation& tria) const {
+        for (typename Triangulation::Node_iterator iter = tria.nodes_begin(); iter != tria.nodes_end(); ++iter) {
+            iter->position() = denormalize(iter->position());
+        }
+        for (typename Triangulation::Face_iterator iter = tria.faces_begin(); iter != tria.faces_end(); ++iter) {
+            iter->invalidate_quality();
+        }
+    }
+
+    Point2 const& origin() const { return origin_; }
+    double        scale()  const { return scale_; }
+
+private:
+    void init(Bounding_box const& bb);
+
+    Point2 origin_;
+    double scale_;
+};
+
+} // namespace umeshu
+
+#endif // __COORDINATE_NORMALIZATION_H_INCLUDED__
@@ -22,13 +22,25 @@
 #ifndef __DELAUNAY_MESHER_H_INCLUDED__
 #define __DELAUNAY_MESHER_H_INCLUDED__ 
 
+#include "Background_grid.h"
+#include "Local_feature_size.h"
 #include "Triangulation.h"
 #include "Utils.h"
 
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered/unordered_map.hpp>
 #include <boost/unordered/unordered_set.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <set>
 #include <stack>
+#include <vector>
 
 namespace umeshu {
 
@@ -45,19 +57,23 @@ public:
     typedef typename Tria::Edge_handle           Edge_handle;
     typedef typename Tria::Face_handle           Face_handle;
 
-    Delaunay_mesh_area_quality(Face_handle f) : face_(f) {
-        Point_2 p1, p2, p3;
-        face_->vertices(p1, p2, p3);
-        area_ = Kernel::signed_area(p1, p2, p3);
+    Delaunay_mesh_area_quality(Face_handle f)
+        : face_(f)
+        , area_(f->area())
+        , min_angle_sine_squared_(f->min_angle_sine_squared())
+    {
         BOOST_ASSERT(area_ > 0.0);
-        double a1, a2, a3;
-        Kernel::triangle_angles(p1, p2, p3, a1, a2, a3);
-        min_angle_ = std::min(a1, std::min(a2, a3));
     }
 
     Face_handle face() const { return face_; }
     double area() const { return area_; }
-    double min_angle() const { return min_angle_; }
+    double min_angle_sine_squared() const { return min_angle_sine_squared_; }
+
+    // the angle bound is passed as the squared sine of the minimum angle so
+    // that no trigonometric functions are evaluated per face
+    bool is_bad(double max_area, double min_angle_sine_squared) const {
+        return area() > max_area || min_angle_sine_squared_ < min_angle_sine_squared;
+    }
 
     bool operator< (Self const& q) const {
         if (q.face() != face()) {
@@ -66,9 +82,9 @@ public:
             } else if (area() < q.area()) {
                 return false;
             } else { // areas are equal
-                if (min_angle() < q.min_angle()) {
+                if (min_angle_sine_squared() < q.min_angle_sine_squared()) {
                     return true;
-                } else if (min_angle() > q.min_angle()) {
+                } else if (min_angle_sine_squared() > q.min_angle_sine_squared()) {
                     return false;
                 } else { // areas and min angles are equal
                     return &(*(face())) < &(*(q.face()));
@@ -81,7 +97,7 @@ public:
 private:
     Face_handle face_;
     double area_;
-    double min_angle_;
+    double min_angle_sine_squared_;
 };
 
 template <typename Delaunay_triangulation, typename Quality = Delaunay_mesh_area_quality<Delaunay_triangulation> >
@@ -121,20 +137,307 @@ public:
         }
     };
 
+    struct Node_handle_hash {
+        size_t operator()(Node_handle const& n) const
+        {
+            return boost::hash<Node*>()(&(*n));
+        }
+    };
+
     typedef boost::unordered_set<Halfedge_handle, Halfedge_handle_hash> Encroached_halfedges;
+    typedef boost::unordered_set<Halfedge_handle, Halfedge_handle_hash> Halfedge_set;
     typedef std::set<Quality> Bad_faces;
-    typedef std::stack<Edge_handle> Undo_stack;
+    typedef std::vector<Face_handle> Faces;
+    typedef std::vector<Halfedge_handle> Halfedges;
+
+    // Steiner points inserted to kill bad faces are either circumcenters
+    // (Ruppert, Chew) or off-centers (Ungor), which lie on the bisector of
+    // the shortest edge and yield meshes with fewer nodes
+    enum Steiner_point {CIRCUMCENTER, OFFCENTER};
+
+    // maximum area of faces as a function of position
+    typedef boost::function<double (Point_2 const&)> Sizing_field;
+
+    // target area of each face of a mesh, e.g. from an error estimate
+    typedef boost::function<double (Face_handle)> Face_sizing;
+
+    // state of the refinement reported to the progress callback
+    struct Progress {
+        size_t number_of_nodes;
+        size_t inserted_nodes;
+        size_t bad_faces;
+        double elapsed_seconds;
+    };
+
+    // returns false to stop the refinement
+    typedef boost::function<bool (Progress const&)> Progress_callback;
+
+    // Counters of the work done by the last call to refine. The phase times
+    // are only measured when timing is switched on; the splitting time is
+    // part of the insertion time except for the edges split before the
+    // refinement starts.
+    struct Statistics {
+        size_t steiner_points;      // points inserted to kill bad faces
+        size_t edge_splits;         // boundary edges split
+        size_t flips;
+        size_t rejected_points;     // Steiner points that were not inserted
+        size_t removed_nodes;       // nodes removed by adapt
+        size_t locate_steps;        // orientation tests done by point location
+        size_t incircle_tests;
+        size_t enqueued_faces, dequeued_faces;
+        double locate_seconds, cavity_seconds, insertion_seconds, splitting_seconds;
+
+        Statistics()
+            : steiner_points(0), edge_splits(0), flips(0), rejected_points(0), removed_nodes(0)
+            , locate_steps(0), incircle_tests(0), enqueued_faces(0), dequeued_faces(0)
+            , locate_seconds(0.0), cavity_seconds(0.0), insertion_seconds(0.0), splitting_seconds(0.0)
+        {}
+    };
 
     explicit Delaunay_mesher ()
         : mesh_(NULL)
         , max_area_(1.0)
-        , min_angle_(utils::degrees_to_radians(20.0))
+        , min_angle_sine_squared_(std::pow(std::sin(utils::degrees_to_radians(20.0)), 2))
+        , steiner_point_(CIRCUMCENTER)
+        , offconstant_(0.0)
+        , touched_faces_(NULL)
+        , node_budget_(0)
+        , progress_interval_(100)
+        , time_limit_(0.0)
+        , stop_requested_(false)
+        , timing_(false)
+        , has_interior_constraints_(false)
     {}
 
+    void set_steiner_point (Steiner_point sp) { steiner_point_ = sp; }
+    Steiner_point steiner_point () const { return steiner_point_; }
+
+    // The sizing field is evaluated at the centroids of faces and the
+    // maximum area passed to refine caps it. Parallel meshers evaluate it
+    // from several threads at once.
+    void set_sizing_field (Sizing_field const& sizing_field) { sizing_field_ = sizing_field; }
+    Sizing_field const& sizing_field () const { return sizing_field_; }
+
+    // Caps the area of the faces of a region, see
+    // Delaunay_triangulation::mark_region. The regions are separated by
+    // constrained edges, which are split like the boundary when encroached
+    // upon, and new faces inherit the regions of the faces they replace.
+    void set_region_max_area (int region, double max_area) { region_max_areas_[region] = max_area; }
+    void clear_region_max_areas () { region_max_areas_.clear(); }
+
+    // Sizes the faces automatically from the local feature size of the
+    // boundary of the domain, so that narrow channels and short boundary
+    // edges get small faces and open regions large ones. The edge lengths
+    // are the local feature size divided by elements_per_feature and grow
+    // by at most grading per unit distance. The max_area passed to refine
+    // still caps the sizing.
+    void set_automatic_sizing (Polygon const& boundary, double elements_per_feature = 2.0, double grading = 0.5) {
+        Local_feature_size<Delaunay_triangulation> lfs(boundary);
+        boost::shared_ptr<Background_grid> grid(new Background_grid(lfs.sizing_grid(elements_per_feature, grading)));
+        sizing_field_ = boost::bind(&Background_grid::operator(), grid, _1);
+    }
+
+    // Refinement stops as soon as the mesh has at least the given number of
+    // nodes, which can be exceeded by the few nodes inserted when splitting
+    // encroached boundary edges. Zero means no budget.
+    void set_node_budget (size_t number_of_nodes) { node_budget_ = number_of_nodes; }
+    size_t node_budget () const { return node_budget_; }
+
+    // The progress callback is called after every interval refinement steps
+    // and once more when the refinement ends. Refinement also stops when the
+    // time limit in seconds runs out; zero means no limit. Stopping or
+    // cancelling the refinement from the callback leaves a valid conforming
+    // mesh that is the best one reached so far.
+    void set_progress_callback (Progress_callback const& callback, size_t interval = 100) {
+        progress_callback_ = callback;
+        progress_interval_ = std::max<size_t>(1, interval);
+    }
+    void set_time_limit (double seconds) { time_limit_ = seconds; }
+    double time_limit () const { return time_limit_; }
+
+    // Fixed boundary edges are never split. Steiner points that encroach
+    // upon them are inserted anyway and bad faces whose Steiner points lie
+    // beyond them are left in the mesh.
+    void fix_edge (Edge_handle e) { fixed_edges_.insert(&*e); }
+    void clear_fixed_edges () { fixed_edges_.clear(); }
+
+    Statistics const& statistics () const { return statistics_; }
+    void set_timing (bool timing) { timing_ = timing; }
+    bool timing () const { return timing_; }
+
     void refine (Delaunay_triangulation& mesh, double max_area, double min_angle) {
-        mesh_ = &mesh;
-        max_area_ = max_area;
-        min_angle_ = utils::degrees_to_radians(min_angle);
+        initialize(mesh, max_area, min_angle);
+        while (not is_refined()) {
+            insertion_.bad_face = bad_faces_.begin()->face();
+            prepare_insertion(insertion_);
+            perform_insertion(insertion_);
+        }
+        finalize();
+    }
+
+    // Refines the largest faces first until the mesh has the given number
+    // of nodes, which yields the best mesh that fits the budget.
+    void refine_to_node_budget (Delaunay_triangulation& mesh, size_t number_of_nodes, double min_angle) {
+        BOOST_ASSERT(number_of_nodes > 0);
+        size_t node_budget = node_budget_;
+        node_budget_ = number_of_nodes;
+        refine(mesh, 0.0, min_angle);
+        node_budget_ = node_budget;
+    }
+
+    // Refines only the bad faces among the given ones and the faces created
+    // while refining them, e.g. to repair a mesh that is refined everywhere
+    // except around the given faces. Of the boundary edges, only those of
+    // the given faces and those encroached upon by new points are split.
+    void refine_faces (Delaunay_triangulation& mesh, Faces const& faces, double max_area, double min_angle) {
+        set_up(mesh, max_area, min_angle);
+        node_targets_.clear();
+        for (typename Faces::const_iterator iter = faces.begin(); iter != faces.end(); ++iter) {
+            Halfedge_handle he = (*iter)->halfedge();
+            for (int i = 0; i < 3; ++i, he = he->next()) {
+                if (he->edge()->is_constrained() && he->edge()->is_encroached_upon(he->prev()->origin()->position())) {
+                    enc_hedges_.insert(he);
+                }
+            }
+            enqueue_bad_face(*iter);
+        }
+        split_encroached_boundary_edges(true);
+        while (not is_refined()) {
+            insertion_.bad_face = bad_faces_.begin()->face();
+            prepare_insertion(insertion_);
+            perform_insertion(insertion_);
+        }
+        finalize();
+    }
+
+    // Appends the faces of the mesh refined last that are still bad, i.e.,
+    // those left because of fixed edges, the node budget or a stop.
+    void collect_bad_faces (Faces& faces) const {
+        for (Face_iterator iter = mesh_->faces_begin(); iter != mesh_->faces_end(); ++iter) {
+            if (is_bad(Quality(iter))) {
+                faces.push_back(iter);
+            }
+        }
+    }
+
+    // Adapts a mesh refined by this mesher to new target areas of its faces,
+    // as in an adaptive solver loop. The target areas are spread to the
+    // nodes, a node getting the smallest target of its faces, and the
+    // maximum area of a face is the mean of the targets of its nodes.
+    // Interior nodes whose targets grew are removed as long as the faces
+    // that replace them are not too large, and then the faces around nodes
+    // whose targets shrank or that lost neighbours are refined. The
+    // targets of the nodes are kept between adaptations; refine starts
+    // afresh. Boundary nodes are never removed. This evaluates the targets
+    // of all faces; see the overload below for local changes.
+    void adapt (Delaunay_triangulation& mesh, Face_sizing const& target_area, double min_angle) {
+        set_up(mesh, std::numeric_limits<double>::max(), min_angle);
+
+        Node_targets targets;
+        for (Face_iterator iter = mesh_->faces_begin(); iter != mesh_->faces_end(); ++iter) {
+            double target = target_area(iter);
+            BOOST_ASSERT(target > 0.0);
+            Halfedge_handle he = iter->halfedge();
+            for (int i = 0; i < 3; ++i, he = he->next()) {
+                std::pair<typename Node_targets::iterator, bool> ins = targets.insert(std::make_pair(&*he->origin(), target));
+                if (not ins.second) {
+                    ins.first->second = std::min(ins.first->second, target);
+                }
+            }
+        }
+
+        Nodes coarsen;
+        Touched_nodes touched;
+        for (Node_iterator iter = mesh_->nodes_begin(); iter != mesh_->nodes_end(); ++iter) {
+            classify_node_target(iter, targets[&*iter], coarsen, touched);
+        }
+        node_targets_.swap(targets);
+        adapt_nodes(coarsen, touched);
+    }
+
+    // Adapts the mesh when only the targets of the given faces changed
+    // since the previous adaptation of the same mesh. The targets are
+    // evaluated for the faces around the nodes of the changed faces only,
+    // so the work is proportional to the changed region and to the faces
+    // refined or coarsened there. Without a previous adaptation of the
+    // mesh, all faces are evaluated as above. Constrained edges inserted
+    // into the mesh since then are not noticed.
+    void adapt (Delaunay_triangulation& mesh, Faces const& changed, Face_sizing const& target_area, double min_angle) {
+        if (mesh_ != &mesh || node_targets_.empty()) {
+            adapt(mesh, target_area, min_angle);
+            return;
+        }
+        set_up(mesh, std::numeric_limits<double>::max(), min_angle, false);
+
+        Node_targets targets;
+        Nodes nodes;
+        for (typename Faces::const_iterator iter = changed.begin(); iter != changed.end(); ++iter) {
+            Halfedge_handle he = (*iter)->halfedge();
+            for (int i = 0; i < 3; ++i, he = he->next()) {
+                Node_handle n = he->origin();
+                if (targets.find(&*n) != targets.end()) {
+                    continue;
+                }
+                double target = std::numeric_limits<double>::max();
+                Halfedge_handle he_start = n->halfedge();
+                Halfedge_handle he_iter = he_start;
+                do {
+                    if (not he_iter->is_boundary()) {
+                        target = std::min(target, target_area(he_iter->face()));
+                    }
+                    he_iter = he_iter->pair()->next();
+                } while (he_iter != he_start);
+                BOOST_ASSERT(target > 0.0);
+                targets[&*n] = target;
+                nodes.push_back(n);
+            }
+        }
+
+        Nodes coarsen;
+        Touched_nodes touched;
+        for (typename Nodes::const_iterator iter = nodes.begin(); iter != nodes.end(); ++iter) {
+            double target = targets[&**iter];
+            classify_node_target(*iter, target, coarsen, touched);
+            node_targets_[&**iter] = target;
+        }
+        adapt_nodes(coarsen, touched);
+    }
+
+protected:
+    struct Cavity {
+        Faces           faces;
+        Halfedges       boundary;
+        // the halfedges of boundary, for constant-time membership tests
+        Halfedge_set    boundary_set;
+        Halfedge_handle split_halfedge;
+        size_t          incircle_tests;
+    };
+
+    // Steiner point proposed for a bad face together with everything that is
+    // needed to decide whether and how to insert it
+    struct Insertion {
+        Face_handle                 bad_face;
+        Point_2                     point;
+        Point_location              loc;
+        Face_handle                 face;
+        Edge_handle                 edge;
+        Cavity                      cavity;
+        std::stack<Halfedge_handle> encroached;
+        bool                        topology_failed;
+        size_t                      locate_steps;
+        double                      locate_seconds, cavity_seconds;
+    };
+
+    typedef boost::unordered_set<Face const*> Touched_faces;
+    typedef boost::unordered_set<Edge const*> Fixed_edges;
+    typedef boost::unordered_map<Node const*, double> Node_targets;
+    typedef boost::unordered_set<Node_handle, Node_handle_hash> Touched_nodes;
+    typedef std::vector<Node_handle> Nodes;
+    typedef std::map<int, double> Region_max_areas;
+
+    void initialize (Delaunay_triangulation& mesh, double max_area, double min_angle) {
+        set_up(mesh, max_area, min_angle);
+        node_targets_.clear();
 
         collect_encroached_boundary_edges();
         split_encroached_boundary_edges(false);
@@ -143,89 +446,241 @@ public:
         for (Face_iterator iter = mesh_->faces_begin(); iter != mesh_->faces_end(); ++iter) {
             enqueue_bad_face(iter);
         }
+    }
 
-        while (not bad_faces_.empty()) {
-            Face_handle bad_face = bad_faces_.begin()->face();
-            Point_2 center = bad_face->circumcenter();
-            Node_handle n1, n2, n3;
-            bad_face->nodes(n1, n2, n3);
-
-            Point_location loc;
-            Face_handle face_to_kill;
-            Edge_handle edge_to_kill;
-            Node_handle node_to_kill;
-            face_to_kill = mesh_->locate(center, loc, node_to_kill, edge_to_kill, bad_face);
-            BOOST_ASSERT(loc != ON_NODE);
-
-            std::stack<Halfedge_handle> E;
-            if (loc == IN_FACE) {
-                Node_handle new_node = try_kill_face(face_to_kill, center, E);
-                if (E.empty()) {
-                    clear_undo_stack();
-                    treat_new_node(new_node, true);                
-                } else {
-                    undo_kill_face(new_node);
-                    bad_face = get_original_bad_face(n1, n2, n3);
-                    BOOST_ASSERT(bad_face != Face_handle());
-                    finish_dealing_with_bad_face(bad_face, E);
-                }
-            } else if (loc == ON_EDGE) {
-                bool build_123 = not edge_to_kill->he1()->is_boundary();
-                bool build_142 = not edge_to_kill->he2()->is_boundary();
-                Node_handle n1_ = edge_to_kill->he1()->origin();
-                Node_handle n2_ = edge_to_kill->he2()->origin();
-                Node_handle new_node = try_kill_edge(edge_to_kill, center, E);
-                if (E.empty()) {
-                    clear_undo_stack();
-                    treat_new_node(new_node, true);   
-                } else {
-                    undo_kill_edge(new_node, n1_, n2_, build_123, build_142);
-                    bad_face = get_original_bad_face(n1, n2, n3);
-                    BOOST_ASSERT(bad_face != Face_handle());
-                    finish_dealing_with_bad_face(bad_face, E);
-                }
-            } else { // loc == OUTSIDE_MESH:
-                Edge_handle e = edge_to_kill;
-                BOOST_ASSERT(e->is_boundary());
-                if (e->he1()->is_boundary()) {
-                    enc_hedges_.insert(e->he1());
-                } else {
-                    enc_hedges_.insert(e->he2());
+    // The edges are scanned for interior constraints unless the flag of the
+    // previous run on the same mesh is kept.
+    void set_up (Delaunay_triangulation& mesh, double max_area, double min_angle, bool find_interior_constraints = true) {
+        mesh_ = &mesh;
+        max_area_ = max_area;
+        min_angle_sine_squared_ = std::pow(std::sin(utils::degrees_to_radians(min_angle)), 2);
+        double cos_min_angle = std::cos(utils::degrees_to_radians(min_angle));
+        offconstant_ = 0.475*std::sqrt((1.0 + cos_min_angle)/(1.0 - cos_min_angle));
+
+        start_time_ = boost::posix_time::microsec_clock::universal_time();
+        initial_number_of_nodes_ = mesh_->number_of_nodes();
+        steps_since_progress_ = 0;
+        stop_requested_ = false;
+        statistics_ = Statistics();
+
+        if (not find_interior_constraints) {
+            return;
+        }
+        has_interior_constraints_ = false;
+        for (Edge_iterator iter = mesh_->edges_begin(); iter != mesh_->edges_end() && not has_interior_constraints_; ++iter) {
+            has_interior_constraints_ = iter->is_constrained() && not iter->is_boundary();
+        }
+    }
+
+    // Locates the Steiner point of the bad face, computes its cavity and
+    // collects the boundary edges that the point would encroach upon. A
+    // point that lies on an interior constrained edge or cannot be seen from
+    // the bad face because such an edge is in the way is treated as if it
+    // lay outside of the mesh beyond that edge. The mesh is only read, not
+    // modified, and the work done is recorded in the insertion and added to
+    // the statistics when it is performed.
+    void prepare_insertion (Insertion& ins) const {
+        boost::posix_time::ptime t0 = now();
+        ins.point = steiner_point(ins.bad_face);
+        Node_handle node;
+        ins.locate_steps = 0;
+        ins.topology_failed = false;
+        ins.cavity.faces.clear();
+        ins.cavity.boundary.clear();
+        ins.cavity.boundary_set.clear();
+        ins.cavity.incircle_tests = 0;
+        try {
+            ins.face = mesh_->locate(ins.point, ins.loc, node, ins.edge, ins.bad_face, &ins.locate_steps);
+        }
+        catch (topology_error&) {
+            // reported by perform_insertion, which does not run in the
+            // worker threads of the parallel mesher
+            ins.topology_failed = true;
+            ins.cavity_seconds = 0.0;
+            return;
+        }
+        boost::posix_time::ptime t1 = now();
+        ins.locate_seconds = seconds_between(t0, t1);
+
+        while (not ins.encroached.empty()) {
+            ins.encroached.pop();
+        }
+        if (ins.loc == ON_EDGE && ins.edge->is_constrained() && not ins.edge->is_boundary()) {
+            ins.loc = OUTSIDE_MESH;
+        }
+        if (ins.loc == IN_FACE) {
+            compute_cavity(ins.cavity, ins.face, ins.point, Edge_handle());
+        } else if (ins.loc == ON_EDGE) {
+            compute_cavity(ins.cavity, Face_handle(), ins.point, ins.edge);
+        } else {
+            ins.cavity_seconds = 0.0;
+            return;
+        }
+        if (not Kernel::has_exact_predicates && not is_star_shaped(ins.cavity, ins.point)) {
+            ins.topology_failed = true;
+            ins.cavity_seconds = seconds_between(t1, now());
+            return;
+        }
+        if (has_interior_constraints_ &&
+            std::find(ins.cavity.faces.begin(), ins.cavity.faces.end(), ins.bad_face) == ins.cavity.faces.end())
+        {
+            Edge_handle e = find_blocking_constraint(ins.bad_face, ins.point);
+            if (e != Edge_handle()) {
+                ins.loc = OUTSIDE_MESH;
+                ins.edge = e;
+                ins.cavity_seconds = seconds_between(t1, now());
+                return;
+            }
+        }
+        collect_encroached_boundary_edges(ins.cavity, ins.point, ins.encroached);
+        ins.cavity_seconds = seconds_between(t1, now());
+    }
+
+    // Walks along the segment from the centroid of f to p and returns the
+    // first constrained edge that it crosses, if any.
+    Edge_handle find_blocking_constraint (Face_handle f, Point_2 const& p) const {
+        Point_2 p1, p2, p3;
+        f->vertices(p1, p2, p3);
+        Point_2 c = Kernel::barycenter(p1, p2, p3);
+        while (true) {
+            Halfedge_handle he = f->halfedge();
+            Halfedge_handle exit;
+            for (int i = 0; i < 3 && exit == Halfedge_handle(); ++i, he = he->next()) {
+                Point_2 a, b;
+                he->vertices(a, b);
+                if (Kernel::oriented_side(a, b, p) == Kernel::ON_NEGATIVE_SIDE &&
+                    Kernel::oriented_side(c, p, a) != Kernel::ON_POSITIVE_SIDE &&
+                    Kernel::oriented_side(c, p, b) != Kernel::ON_NEGATIVE_SIDE)
+                {
+                    exit = he;
                 }
-                split_encroached_boundary_edges(true);
             }
+            if (exit == Halfedge_handle()) {
+                return Edge_handle();
+            }
+            if (exit->edge()->is_constrained()) {
+                return exit->edge();
+            }
+            f = exit->pair()->face();
         }
     }
 
-private:
+    // Inserts the Steiner point prepared by prepare_insertion. A point that
+    // lies outside of the mesh or encroaches upon boundary edges is rejected
+    // and the encroached edges are split instead.
+    void perform_insertion (Insertion& ins) {
+        boost::posix_time::ptime t0 = now();
+        statistics_.locate_steps += ins.locate_steps;
+        statistics_.incircle_tests += ins.loc == OUTSIDE_MESH ? 0 : ins.cavity.incircle_tests;
+        statistics_.locate_seconds += ins.locate_seconds;
+        statistics_.cavity_seconds += ins.cavity_seconds;
+
+        if (ins.topology_failed) {
+            throw topology_error();
+        } else if (ins.loc == ON_NODE) {
+            // a kernel that snaps the points to a grid can snap the Steiner
+            // point onto a node
+            ++statistics_.rejected_points;
+            dequeue_bad_face(ins.bad_face);
+        } else if (ins.loc != IN_FACE && is_fixed(ins.edge)) {
+            ++statistics_.rejected_points;
+            dequeue_bad_face(ins.bad_face);
+        } else if (ins.loc == OUTSIDE_MESH) {
+            ++statistics_.rejected_points;
+            Edge_handle e = ins.edge;
+            BOOST_ASSERT(e->is_constrained());
+            enc_hedges_.insert(e->he1()->is_boundary() ? e->he2() : e->he1());
+            split_encroached_boundary_edges(true);
+        } else if (ins.encroached.empty()) {
+            Node_handle new_node = insert_in_cavity(ins.cavity, ins.point);
+            treat_new_node(new_node, true);
+            ++statistics_.steiner_points;
+        } else {
+            ++statistics_.rejected_points;
+            finish_dealing_with_bad_face(ins.bad_face, ins.encroached);
+        }
+        statistics_.insertion_seconds += seconds_between(t0, now());
+        if (++steps_since_progress_ == progress_interval_) {
+            check_progress();
+        }
+    }
+
+    void finalize () {
+        if (not stop_requested_) {
+            check_progress();
+        }
+        bad_faces_.clear();
+    }
+
+    void check_progress () {
+        steps_since_progress_ = 0;
+        if (progress_callback_.empty() && time_limit_ <= 0.0) {
+            return;
+        }
+        Progress progress;
+        progress.number_of_nodes = mesh_->number_of_nodes();
+        progress.inserted_nodes = progress.number_of_nodes - initial_number_of_nodes_;
+        progress.bad_faces = bad_faces_.size();
+        boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start_time_;
+        progress.elapsed_seconds = elapsed.total_microseconds()*1e-6;
+        if (not progress_callback_.empty() && not progress_callback_(progress)) {
+            stop_requested_ = true;
+        }
+        if (time_limit_ > 0.0 && progress.elapsed_seconds >= time_limit_) {
+            stop_requested_ = true;
+        }
+    }
+
+    Point_2 steiner_point (Face_handle f) const {
+        // faces that are too large are split at their circumcenters anyway
+        if (steiner_point_ == OFFCENTER && f->area() <= max_area(f)) {
+            return f->offcenter(offconstant_);
+        }
+        return f->circumcenter();
+    }
+
+    // Boundary edges and interior constrained edges are the segments of the
+    // domain that are split when encroached upon.
     void collect_encroached_boundary_edges () {
-        Halfedge_handle bhe_start = mesh_->boundary_halfedge();
-        BOOST_ASSERT(bhe_start != Halfedge_handle());
-        Halfedge_handle bhe_iter = bhe_start;
-        do {
-            Halfedge_handle he = bhe_iter->pair();
-            BOOST_ASSERT(he->face() != Face_handle());
-            if (he->edge()->is_encroached_upon(he->prev()->origin()->position())) {
-                enc_hedges_.insert(he);
+        for (Edge_iterator iter = mesh_->edges_begin(); iter != mesh_->edges_end(); ++iter) {
+            if (not iter->is_constrained()) {
+                continue;
+            }
+            Halfedge_handle he = iter->he1();
+            for (int i = 0; i < 2; ++i, he = he->pair()) {
+                if (not he->is_boundary() && he->edge()->is_encroached_upon(he->prev()->origin()->position())) {
+                    enc_hedges_.insert(he);
+                }
             }
-            bhe_iter = bhe_iter->next();
-        } while (bhe_iter != bhe_start);
+        }
     }
 
     void split_encroached_boundary_edges (bool check_quality) {
+        boost::posix_time::ptime t0 = now();
         while (not enc_hedges_.empty()) {        
             Halfedge_handle he = *enc_hedges_.begin();
             enc_hedges_.erase(enc_hedges_.begin());
+            // an interior segment can be encroached upon from both sides
+            enc_hedges_.erase(he->pair());
+            if (is_fixed(he->edge())) {
+                continue;
+            }
 
             Halfedge_handle hen = he->next();
             Halfedge_handle hep = he->prev();
+            // edges of the face on the other side of an interior segment
+            Halfedge_handle pen, pep;
+            if (not he->pair()->is_boundary()) {
+                pen = he->pair()->next();
+                pep = he->pair()->prev();
+            }
 
             Point_2 porig, pdest;
             he->vertices(porig, pdest);
 
             double split;
-            bool acutedest = hen->pair()->is_boundary();
-            bool acuteorig = hep->pair()->is_boundary();
+            bool acutedest = hen->edge()->is_constrained();
+            bool acuteorig = hep->edge()->is_constrained();
             if (acutedest != acuteorig) {
                 double l = Kernel::distance(porig, pdest);
                 double nearestpoweroftwo = 1.0;
@@ -243,34 +698,49 @@ private:
                 split = 0.5;
             }
 
-            Point_2 split_point(porig.x()+split*(pdest.x()-porig.x()), porig.y()+split*(pdest.y()-porig.y()));
+            Point_2 split_point = Kernel::snap(Point_2(porig.x()+split*(pdest.x()-porig.x()), porig.y()+split*(pdest.y()-porig.y())));
+            if (split_point == porig || split_point == pdest) {
+                // the edge is too short to be split on the grid of the kernel
+                fix_edge(he->edge());
+                continue;
+            }
             Node_handle new_node;
             if (check_quality) {
                 new_node = insert_in_edge(he->edge(), split_point);
             } else {
                 new_node = mesh_->insert_in_edge(he->edge(), split_point);
             }
+            ++statistics_.edge_splits;
             Halfedge_handle he1 = hen->prev();
             Halfedge_handle he2 = hep->next();
 
-            recursive_flip_delaunay(hen, check_quality, false);
-            recursive_flip_delaunay(hep, check_quality, false);
+            recursive_flip_delaunay(hen, check_quality);
+            recursive_flip_delaunay(hep, check_quality);
+            if (pen != Halfedge_handle()) {
+                recursive_flip_delaunay(pen, check_quality);
+                recursive_flip_delaunay(pep, check_quality);
+            }
 
             treat_new_node(new_node, check_quality);
 
-            if (he1->edge()->is_encroached_upon(he1->prev()->origin()->position())) {
-                enc_hedges_.insert(he1);
-            }
-            if (he2->edge()->is_encroached_upon(he2->prev()->origin()->position())) {
-                enc_hedges_.insert(he2);
+            Halfedge_handle halves[4] = {he1, he2, he1->pair(), he2->pair()};
+            for (int i = 0; i < 4; ++i) {
+                if (not halves[i]->is_boundary() &&
+                    halves[i]->edge()->is_encroached_upon(halves[i]->prev()->origin()->position()))
+                {
+                    enc_hedges_.insert(halves[i]);
+                }
             }
         }
+        statistics_.splitting_seconds += seconds_between(t0, now());
     }
 
     Node_handle insert_in_edge(Edge_handle e, Point_2 const& p) {
         dequeue_bad_face(e->he1()->face());
         dequeue_bad_face(e->he2()->face());
+        double target = 0.5*(node_target(e->he1()->origin()) + node_target(e->he2()->origin()));
         Node_handle new_node = mesh_->insert_in_edge(e, p);
+        set_node_target(new_node, target);
         Halfedge_handle he_start = new_node->halfedge();
         Halfedge_handle he_iter = he_start;
         do {
@@ -280,8 +750,15 @@ private:
         return new_node;
     }
 
-    void recursive_flip_delaunay (Halfedge_handle he, bool check_quality, bool save_to_undo_stack) {
-        if (not he->edge()->is_flippable() || he->edge()->is_delaunay()) {
+    void recursive_flip_delaunay (Halfedge_handle he, bool check_quality) {
+        Edge_handle e = he->edge();
+        if (not e->is_flippable()) {
+            return;
+        }
+        if (not e->is_constrained()) {
+            ++statistics_.incircle_tests;
+        }
+        if (e->is_delaunay()) {
             return;
         }
 
@@ -289,17 +766,14 @@ private:
         Halfedge_handle he2 = he->pair()->prev();
 
         if (check_quality) {
-            flip_edge(he->edge());
+            flip_edge(e);
         } else {
-            he->edge()->flip();
+            e->flip();
         }
+        ++statistics_.flips;
 
-        if (save_to_undo_stack) {
-            undo_stack_.push(he->edge());
-        }
-
-        this->recursive_flip_delaunay(he1, check_quality, save_to_undo_stack);
-        this->recursive_flip_delaunay(he2, check_quality, save_to_undo_stack);
+        this->recursive_flip_delaunay(he1, check_quality);
+        this->recursive_flip_delaunay(he2, check_quality);
     }
 
     void flip_edge (Edge_handle e) {
@@ -317,7 +791,7 @@ private:
             Face_handle f = he_iter->face();
             if (f != Face_handle()) {
                 Edge_handle e = he_iter->next()->edge();
-                if (e->is_boundary() && e->is_encroached_upon(n->position())) {
+                if (e->is_constrained() && e->is_encroached_upon(n->position())) {
                     enc_hedges_.insert(he_iter->next());
                 } else if (check_quality) {
                     enqueue_bad_face(f);
@@ -327,98 +801,148 @@ private:
         } while (he_iter != he_start);    
     }
 
-    Node_handle try_kill_edge (Edge_handle edge_to_kill, Point_2 const& center, std::stack<Halfedge_handle>& E) {
-        Node_handle new_node = insert_in_edge(edge_to_kill, center);
-        Halfedge_handle he_start = new_node->halfedge();
-        Halfedge_handle he_iter  = he_start;
-        do {
-            Halfedge_handle he_next = he_iter->pair()->next();
-            if (not he_iter->is_boundary()) {
-                recursive_flip_delaunay(he_iter->next(), true, true);
+    // Collects the Bowyer-Watson cavity of p, i.e., the faces whose
+    // circumcircles contain p and which can be reached from the face
+    // containing p without crossing a boundary edge. The halfedges bounding
+    // the cavity are stored in counterclockwise order. If p lies on
+    // split_edge, the cavity starts at a face adjacent to that edge and, if
+    // the edge is on the boundary, its halfedge is excluded from the cavity
+    // boundary which then forms an open chain.
+    void compute_cavity (Cavity& cavity, Face_handle f, Point_2 const& p, Edge_handle split_edge) const {
+        cavity.faces.clear();
+        cavity.boundary.clear();
+        cavity.boundary_set.clear();
+        cavity.split_halfedge = Halfedge_handle();
+        cavity.incircle_tests = 0;
+
+        Halfedge_handle he_start;
+        if (split_edge != Edge_handle()) {
+            he_start = split_edge->he1()->is_boundary() ? split_edge->he2() : split_edge->he1();
+            if (split_edge->is_boundary()) {
+                cavity.split_halfedge = he_start;
+                he_start = he_start->next();
             }
-            he_iter = he_next;
+            f = he_start->face();
+        } else {
+            he_start = f->halfedge();
+        }
+
+        cavity.faces.push_back(f);
+        Halfedge_handle he_iter = he_start;
+        do {
+            expand_cavity(cavity, he_iter, p);
+            he_iter = he_iter->next();
         } while (he_iter != he_start);
-        collect_encroached_boundary_edges(new_node, E);
-        return new_node;
     }
 
-    Node_handle try_kill_face(Face_handle face_to_kill, Point_2 const& center, std::stack<Halfedge_handle>& E) {
-        Node_handle new_node = insert_in_face(face_to_kill, center);
-        Halfedge_handle  he1 = new_node->halfedge()->next();
-        Halfedge_handle  he2 = he1->next()->pair()->next();
-        Halfedge_handle  he3 = he2->next()->pair()->next();
-        recursive_flip_delaunay(he1, true, true);
-        recursive_flip_delaunay(he2, true, true);
-        recursive_flip_delaunay(he3, true, true);
-        collect_encroached_boundary_edges(new_node, E);
-        return new_node;
+    void expand_cavity (Cavity& cavity, Halfedge_handle he, Point_2 const& p) const {
+        if (he == cavity.split_halfedge) {
+            return;
+        }
+        Halfedge_handle hep = he->pair();
+        if (he->edge()->is_constrained()) {
+            add_to_boundary(cavity, he);
+            return;
+        }
+        ++cavity.incircle_tests;
+        if (not in_circumcircle(hep->face(), p)) {
+            add_to_boundary(cavity, he);
+            return;
+        }
+        BOOST_ASSERT(std::find(cavity.faces.begin(), cavity.faces.end(), hep->face()) == cavity.faces.end());
+        cavity.faces.push_back(hep->face());
+        expand_cavity(cavity, hep->next(), p);
+        expand_cavity(cavity, hep->prev(), p);
     }
 
-    void undo_kill_face (Node_handle new_node) {
-        undo_swapping();
-        Halfedge_handle he1 = new_node->halfedge()->next();
-        Halfedge_handle he2 = he1->next()->pair()->next();
-        Halfedge_handle he3 = he2->next()->pair()->next();
-        dequeue_bad_face(he1->face());
-        dequeue_bad_face(he2->face());
-        dequeue_bad_face(he3->face());
-        mesh_->remove_node(new_node);
-        Face_handle new_face = mesh_->add_face(he1, he2, he3);
-        enqueue_bad_face(new_face);
+    void add_to_boundary (Cavity& cavity, Halfedge_handle he) const {
+        cavity.boundary.push_back(he);
+        cavity.boundary_set.insert(he);
     }
 
-    void undo_kill_edge (Node_handle new_node, Node_handle n1, Node_handle n2, bool build_123, bool build_142) {
-        undo_swapping();
-
-        Halfedge_handle he1, he2;
-        Halfedge_handle he_start = new_node->halfedge();
-        Halfedge_handle he_iter = he_start;
-        do {
-            if (he_iter->pair()->origin() == n1) {
-                he1 = he_iter;
-            }
-            if (he_iter->pair()->origin() == n2) {
-                he2 = he_iter;
+    // The fan of faces around p that replaces the cavity is valid only if p
+    // lies strictly to the left of all the halfedges bounding the cavity,
+    // which inconsistent incircle tests of an inexact kernel can violate.
+    bool is_star_shaped (Cavity const& cavity, Point_2 const& p) const {
+        for (typename Halfedges::const_iterator iter = cavity.boundary.begin(); iter != cavity.boundary.end(); ++iter) {
+            Point_2 p1, p2;
+            (*iter)->vertices(p1, p2);
+            if (Kernel::oriented_side(p1, p2, p) != Kernel::ON_POSITIVE_SIDE) {
+                return false;
             }
-            he_iter = he_iter->pair()->next();
-        } while (he_iter != he_start);
+        }
+        return true;
+    }
+
+    bool in_circumcircle (Face_handle f, Point_2 const& p) const {
+        Point_2 p1, p2, p3;
+        f->vertices(p1, p2, p3);
+        return Kernel::oriented_circle(p1, p2, p3, p) == Kernel::ON_POSITIVE_SIDE;
+    }
+
+    // Replaces the cavity computed by compute_cavity with a fan of faces
+    // around a new node at p.
+    Node_handle insert_in_cavity (Cavity const& cavity, Point_2 const& p) {
+        for (typename Faces::const_iterator iter = cavity.faces.begin(); iter != cavity.faces.end(); ++iter) {
+            dequeue_bad_face(*iter);
+        }
+        return replace_cavity(cavity, p);
+    }
 
-        Halfedge_handle he23, he31, he14, he42;
-        if (build_123) {
-            he23 = he2->next();
-            he31 = he1->pair()->prev();
-            dequeue_bad_face(he23->face());
-            dequeue_bad_face(he31->face());
+    // Changes only the mesh and not the queue of bad faces, which the
+    // parallel mesher updates separately.
+    Node_handle replace_cavity (Cavity const& cavity, Point_2 const& p) {
+        Edge_handle split_edge = cavity.split_halfedge != Halfedge_handle() ? cavity.split_halfedge->edge() : Edge_handle();
+        Halfedges interior_edges;
+        for (typename Faces::const_iterator iter = cavity.faces.begin(); iter != cavity.faces.end(); ++iter) {
+            Halfedge_handle he_start = (*iter)->halfedge();
+            Halfedge_handle he_iter = he_start;
+            do {
+                if (he_iter == he_iter->edge()->he1() &&
+                    he_iter->edge() != split_edge &&
+                    cavity.boundary_set.find(he_iter) == cavity.boundary_set.end() &&
+                    cavity.boundary_set.find(he_iter->pair()) == cavity.boundary_set.end())
+                {
+                    interior_edges.push_back(he_iter);
+                }
+                he_iter = he_iter->next();
+            } while (he_iter != he_start);
         }
-        if (build_142) {
-            he14 = he1->next();
-            he42 = he2->pair()->prev();
-            dequeue_bad_face(he14->face());
-            dequeue_bad_face(he42->face());
+
+        // the cavity does not extend over constrained edges and thus lies in
+        // a single region
+        int region = cavity.faces.front()->region();
+        for (typename Faces::const_iterator iter = cavity.faces.begin(); iter != cavity.faces.end(); ++iter) {
+            mesh_->remove_face(*iter);
         }
-        mesh_->remove_node(new_node);
-        Halfedge_handle new_he = mesh_->add_edge(n1, n2);
-        if (build_123) {
-            enqueue_bad_face(mesh_->add_face(new_he, he23, he31));
+        for (typename Halfedges::const_iterator iter = interior_edges.begin(); iter != interior_edges.end(); ++iter) {
+            mesh_->remove_edge((*iter)->edge());
         }
-        if (build_142) {
-            enqueue_bad_face(mesh_->add_face(new_he->pair(), he14, he42));
+        if (split_edge != Edge_handle()) {
+            mesh_->remove_edge(split_edge);
         }
-    }
 
-    void undo_swapping() {
-        while (not undo_stack_.empty()) {
-            flip_edge(undo_stack_.top());
-            undo_stack_.pop();
+        Node_handle new_node = mesh_->add_node(p);
+        size_t n = cavity.boundary.size();
+        if (not node_targets_.empty()) {
+            double target = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                target += node_target(cavity.boundary[i]->origin());
+            }
+            set_node_target(new_node, target/n);
+        }
+        bool closed = cavity.split_halfedge == Halfedge_handle();
+        Halfedges spokes;
+        for (size_t i = 0; i < n; ++i) {
+            spokes.push_back(mesh_->add_edge(new_node, cavity.boundary[i]->origin()));
+        }
+        if (not closed) {
+            spokes.push_back(mesh_->add_edge(new_node, cavity.boundary[n-1]->pair()->origin()));
+        }
+        for (size_t i = 0; i < n; ++i) {
+            Halfedge_handle next_spoke = (closed && i == n-1) ? spokes[0] : spokes[i+1];
+            mesh_->add_face(spokes[i], cavity.boundary[i], next_spoke->pair())->set_region(region);
         }
-    }
-
-    Node_handle insert_in_face(Face_handle f, Point_2 const& p) {
-        dequeue_bad_face(f);
-        Node_handle new_node = mesh_->insert_in_face(f, p);
-        enqueue_bad_face(new_node->halfedge()->face());
-        enqueue_bad_face(new_node->halfedge()->pair()->face());
-        enqueue_bad_face(new_node->halfedge()->prev()->pair()->face());
         return new_node;
     }
 
@@ -434,7 +958,7 @@ private:
             l2 = Kernel::distance(p2, p3);
             l3 = Kernel::distance(p3, p1);
             double d = std::min(l1, std::min(l2, l3));
-            if (q.area() > max_area_ || split_permitted(he, d)) {
+            if (q.area() > max_area(bad_face) || split_permitted(he, d)) {
                 enc_hedges_.insert(he);
             }
         }
@@ -447,8 +971,8 @@ private:
 
     bool split_permitted (Halfedge_handle he, double d)
     {
-        bool prev_b = he->prev()->edge()->is_boundary();
-        bool next_b = he->next()->edge()->is_boundary();
+        bool prev_b = he->prev()->edge()->is_constrained();
+        bool next_b = he->next()->edge()->is_constrained();
         if (prev_b == next_b) {
             return true;
         }
@@ -485,76 +1009,286 @@ private:
         return false;
     }
 
-    void collect_encroached_boundary_edges(Node_handle n, std::stack<Halfedge_handle>& E) {
-        Halfedge_handle he_start = n->halfedge();
-        Halfedge_handle he_iter = he_start;
-        do {
-            if (he_iter->face() != Face_handle()) {
-                Edge_handle e = he_iter->next()->edge();
-                if (e->is_boundary() && e->is_encroached_upon(n->position())) {
-                    E.push(he_iter->next());
-                }
+    void collect_encroached_boundary_edges(Cavity const& cavity, Point_2 const& p, std::stack<Halfedge_handle>& E) const {
+        for (typename Halfedges::const_iterator iter = cavity.boundary.begin(); iter != cavity.boundary.end(); ++iter) {
+            Edge_handle e = (*iter)->edge();
+            if (e->is_constrained() && not is_fixed(e) && e->is_encroached_upon(p)) {
+                E.push(*iter);
             }
-            he_iter = he_iter->pair()->next();
-        } while (he_iter != he_start);
+        }
     }
 
     void enqueue_bad_face (Face_handle f) {
         if (f != Face_handle()) {
             Quality q(f);
-            int bhe = 0;
-            if (f->halfedge()->pair()->is_boundary()) ++bhe;
-            if (f->halfedge()->next()->pair()->is_boundary()) ++bhe;
-            if (f->halfedge()->prev()->pair()->is_boundary()) ++bhe;
-            bool restricted = bhe > 1;
-            if (q.area() > max_area_ || (q.min_angle() < min_angle_ && not restricted)) {
-                bad_faces_.insert(q);
+            if (is_bad(q) && bad_faces_.insert(q).second) {
+                ++statistics_.enqueued_faces;
             }
         }
     }
 
+    // Every face is dequeued before it is modified or removed from the mesh,
+    // which makes this the place to record the faces touched by the mesher.
     void dequeue_bad_face (Face_handle f)
     {
         if (f != Face_handle()) {
-            Quality q(f);
-            int bhe = 0;
-            if (f->halfedge()->pair()->is_boundary()) ++bhe;
-            if (f->halfedge()->next()->pair()->is_boundary()) ++bhe;
-            if (f->halfedge()->prev()->pair()->is_boundary()) ++bhe;
-            bool restricted = bhe > 1;
-            if (q.area() > max_area_ || (q.min_angle() < min_angle_ && not restricted)) {
-                bad_faces_.erase(q);
+            if (touched_faces_ != NULL) {
+                touched_faces_->insert(&*f);
+            }
+            // the face is erased even if it is no longer bad, e.g. because
+            // the targets of its nodes changed since it was enqueued
+            if (bad_faces_.erase(Quality(f)) != 0) {
+                ++statistics_.dequeued_faces;
             }
         }
     }
 
-    void clear_undo_stack() {
-       while (not undo_stack_.empty()) {
-            undo_stack_.pop();
+    bool is_refined () const {
+        return bad_faces_.empty() || stop_requested_ ||
+            (node_budget_ != 0 && mesh_->number_of_nodes() >= node_budget_);
+    }
+
+    bool is_fixed (Edge_handle e) const {
+        return not fixed_edges_.empty() && fixed_edges_.find(&*e) != fixed_edges_.end();
+    }
+
+    bool is_bad (Quality const& q) const {
+        Face_handle f = q.face();
+        int bhe = 0;
+        if (f->halfedge()->edge()->is_constrained()) ++bhe;
+        if (f->halfedge()->next()->edge()->is_constrained()) ++bhe;
+        if (f->halfedge()->prev()->edge()->is_constrained()) ++bhe;
+        bool restricted = bhe > 1;
+        return q.is_bad(max_area(f), restricted ? 0.0 : min_angle_sine_squared_);
+    }
+
+    double max_area (Face_handle f) const {
+        Halfedge_handle he = f->halfedge();
+        return max_area(he->origin(), he->next()->origin(), he->prev()->origin(), f->region());
+    }
+
+    double max_area (Node_handle n1, Node_handle n2, Node_handle n3, int region) const {
+        double area = max_area_;
+        if (not region_max_areas_.empty()) {
+            typename Region_max_areas::const_iterator iter = region_max_areas_.find(region);
+            if (iter != region_max_areas_.end()) {
+                area = std::min(area, iter->second);
+            }
         }
+        if (not sizing_field_.empty()) {
+            area = std::min(area, sizing_field_(Kernel::barycenter(n1->position(), n2->position(), n3->position())));
+        }
+        if (not node_targets_.empty()) {
+            area = std::min(area, (node_target(n1) + node_target(n2) + node_target(n3))/3.0);
+        }
+        return area;
     }
 
-    Face_handle get_bad_face () {
-        BOOST_ASSERT(not bad_faces_.empty());
+    double node_target (Node_handle n) const {
+        typename Node_targets::const_iterator iter = node_targets_.find(&*n);
+        return iter != node_targets_.end() ? iter->second : max_area_;
+    }
+
+    // Adds the node to coarsen if its target grew and to touched if it
+    // shrank; a node without a previous target is added to both.
+    void classify_node_target (Node_handle n, double target, Nodes& coarsen, Touched_nodes& touched) const {
+        typename Node_targets::const_iterator old = node_targets_.find(&*n);
+        if (old == node_targets_.end() || target > old->second) {
+            coarsen.push_back(n);
+        }
+        if (old == node_targets_.end() || target < old->second) {
+            touched.insert(n);
+        }
+    }
+
+    // Coarsens around the nodes in coarsen and refines the faces around
+    // the nodes in touched.
+    void adapt_nodes (Nodes const& coarsen, Touched_nodes& touched) {
+        coarsen_nodes(coarsen, touched);
+        for (typename Touched_nodes::const_iterator iter = touched.begin(); iter != touched.end(); ++iter) {
+            Halfedge_handle he_start = (*iter)->halfedge();
+            Halfedge_handle he_iter = he_start;
+            do {
+                enqueue_bad_face(he_iter->face());
+                he_iter = he_iter->pair()->next();
+            } while (he_iter != he_start);
+        }
+
+        while (not is_refined()) {
+            insertion_.bad_face = bad_faces_.begin()->face();
+            prepare_insertion(insertion_);
+            perform_insertion(insertion_);
+        }
+        finalize();
+    }
+
+    void set_node_target (Node_handle n, double target) {
+        if (not node_targets_.empty()) {
+            node_targets_[&*n] = target;
+        }
+    }
+
+    // Removes the candidate nodes whose removal creates no faces that are
+    // too large. The neighbours of a removed node are retried in the next
+    // pass because their stars have grown. Nodes around which the mesh
+    // changed are added to touched.
+    void coarsen_nodes (Nodes candidates, Touched_nodes& touched) {
+        Nodes retry;
+        Touched_nodes changed;
+        Halfedges link;
+        std::vector<size_t> ears;
+        while (not candidates.empty()) {
+            bool removed_any = false;
+            changed.clear();
+            retry.clear();
+            for (typename Nodes::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter) {
+                if (changed.find(*iter) != changed.end()) {
+                    retry.push_back(*iter);
+                } else if (plan_node_removal(*iter, link, ears)) {
+                    touched.erase(*iter);
+                    remove_node(*iter, link, ears, changed);
+                    removed_any = true;
+                }
+            }
+            touched.insert(changed.begin(), changed.end());
+            if (not removed_any) {
+                break;
+            }
+            candidates.swap(retry);
+        }
     }
 
-    Face_handle get_original_bad_face(Node_handle n1, Node_handle n2, Node_handle n3) const {
-        typename Bad_faces::iterator iter = bad_faces_.begin();
-        Node_handle fn1, fn2, fn3;
-        for (; iter != bad_faces_.end(); ++iter) {
-            iter->face()->nodes(fn1, fn2, fn3);
-            if (fn1 == n1 && fn2 == n2 && fn3 == n3 ) return iter->face();
-            if (fn1 == n2 && fn2 == n3 && fn3 == n1 ) return iter->face();
-            if (fn1 == n3 && fn2 == n1 && fn3 == n2 ) return iter->face();
+    // An interior node can be removed if the Delaunay triangulation of the
+    // polygon formed by its neighbours has no faces that are too large. The
+    // angles of the new faces are left to the refinement. Collects the
+    // halfedges of the polygon in counterclockwise order and the ears that
+    // triangulate it.
+    bool plan_node_removal (Node_handle n, Halfedges& link, std::vector<size_t>& ears) const {
+        link.clear();
+        ears.clear();
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            if (he_iter->face() == Face_handle() || he_iter->edge()->is_constrained()) {
+                return false;
+            }
+            link.push_back(he_iter->next());
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        std::reverse(link.begin(), link.end());
+
+        Nodes polygon;
+        for (typename Halfedges::const_iterator iter = link.begin(); iter != link.end(); ++iter) {
+            polygon.push_back((*iter)->origin());
         }
-        return Face_handle();
+        return triangulate_link(polygon, n->halfedge()->face()->region(), ears);
+    }
+
+    // Replaces the star of the node with the planned faces and inserts the
+    // neighbours of the node into changed.
+    void remove_node (Node_handle n, Halfedges& link, std::vector<size_t> const& ears, Touched_nodes& changed) {
+        for (typename Halfedges::const_iterator iter = link.begin(); iter != link.end(); ++iter) {
+            changed.insert((*iter)->origin());
+        }
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            dequeue_bad_face(he_iter->face());
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        int region = he_start->face()->region();
+        node_targets_.erase(&*n);
+        mesh_->remove_node(n);
+        ++statistics_.removed_nodes;
+
+        for (size_t k = 0; k < ears.size(); ++k) {
+            size_t i = ears[k];
+            size_t m = link.size();
+            Halfedge_handle he1 = link[i];
+            Halfedge_handle he2 = link[(i+1)%m];
+            if (m == 3) {
+                mesh_->add_face(he1, he2, link[(i+2)%m])->set_region(region);
+                break;
+            }
+            Halfedge_handle he3 = mesh_->add_edge(he2->pair()->origin(), he1->origin());
+            mesh_->add_face(he1, he2, he3)->set_region(region);
+            link[i] = he3->pair();
+            link.erase(link.begin() + (i+1)%m);
+        }
+    }
+
+    // Delaunay ear clipping of the star-shaped polygon around a removed
+    // node: an ear is cut off if its circumcircle contains no other vertex
+    // of the polygon. Stores the positions of the ears at the time they are
+    // cut off and fails if no ear is found or an ear would be too large.
+    bool triangulate_link (Nodes polygon, int region, std::vector<size_t>& ears) const {
+        while (polygon.size() >= 3) {
+            size_t m = polygon.size();
+            size_t ear = m;
+            for (size_t i = 0; i < m && ear == m; ++i) {
+                Point_2 p1 = polygon[i]->position();
+                Point_2 p2 = polygon[(i+1)%m]->position();
+                Point_2 p3 = polygon[(i+2)%m]->position();
+                if (Kernel::oriented_side(p1, p2, p3) != Kernel::ON_POSITIVE_SIDE) {
+                    continue;
+                }
+                bool empty = true;
+                for (size_t j = 3; j < m && empty; ++j) {
+                    empty = Kernel::oriented_circle(p1, p2, p3, polygon[(i+j)%m]->position()) != Kernel::ON_POSITIVE_SIDE;
+                }
+                if (empty) {
+                    ear = i;
+                }
+            }
+            if (ear == m || is_too_large(polygon[ear], polygon[(ear+1)%m], polygon[(ear+2)%m], region)) {
+                return false;
+            }
+            ears.push_back(ear);
+            polygon.erase(polygon.begin() + (ear+1)%m);
+        }
+        return true;
+    }
+
+    bool is_too_large (Node_handle n1, Node_handle n2, Node_handle n3, int region) const {
+        Point_2 p1 = n1->position(), p2 = n2->position(), p3 = n3->position();
+        double area = 0.5*((p2.x()-p1.x())*(p3.y()-p1.y()) - (p2.y()-p1.y())*(p3.x()-p1.x()));
+        return area > max_area(n1, n2, n3, region);
+    }
+
+    boost::posix_time::ptime now () const {
+        return timing_ ? boost::posix_time::microsec_clock::universal_time() : boost::posix_time::ptime();
+    }
+
+    double seconds_between (boost::posix_time::ptime const& from, boost::posix_time::ptime const& to) const {
+        return timing_ ? (to - from).total_microseconds()*1e-6 : 0.0;
+    }
+
+    Face_handle get_bad_face () {
+        BOOST_ASSERT(not bad_faces_.empty());
     }
 
     Delaunay_triangulation* mesh_;
-    double                  max_area_, min_angle_;
+    double                  max_area_, min_angle_sine_squared_;
+    Steiner_point           steiner_point_;
+    Sizing_field            sizing_field_;
+    double                  offconstant_;
     Encroached_halfedges    enc_hedges_;
     Bad_faces               bad_faces_;
-    Undo_stack              undo_stack_;
+    Insertion               insertion_;
+    Touched_faces*          touched_faces_;
+    Fixed_edges             fixed_edges_;
+    size_t                  node_budget_;
+    Progress_callback       progress_callback_;
+    size_t                  progress_interval_, steps_since_progress_;
+    double                  time_limit_;
+    bool                    stop_requested_;
+    size_t                  initial_number_of_nodes_;
+    boost::posix_time::ptime start_time_;
+    Statistics              statistics_;
+    bool                    timing_;
+    Node_targets            node_targets_;
+    Region_max_areas        region_max_areas_;
+    bool                    has_interior_constraints_;
 };
 
 } // namespace umeshu
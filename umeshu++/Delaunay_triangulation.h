@@ -23,10 +23,15 @@
 #define __DELAUNAY_TRIANGULATION_H_INCLUDED__ 
 
 #include "Exact_adaptive_kernel.h"
+#include "Exceptions.h"
 #include "Triangulation.h"
 
 #include <boost/unordered/unordered_set.hpp>
 
+#include <list>
+#include <stack>
+#include <vector>
+
 namespace umeshu {
 
 template <typename Delaunay_triangulation_items, typename Kernel_ = Exact_adaptive_kernel, typename Alloc = std::allocator<int> >
@@ -59,6 +64,9 @@ public:
     typedef typename Base::Edge_const_handle     Edge_const_handle;
     typedef typename Base::Face_const_handle     Face_const_handle;
 
+    // With an inexact kernel, more flips than the square of the number of
+    // edges, which bounds the flips with consistent predicates, throw
+    // topology_error.
     void make_cdt() {
         boost::unordered_set<Edge_iterator, edge_iterator_hash> edges_to_flip;
         for (Edge_iterator iter = this->edges_begin(); iter != this->edges_end(); ++iter) {
@@ -67,21 +75,257 @@ public:
             }
         }
 
+        flip_non_delaunay_edges(edges_to_flip, NULL);
+    }
+
+    // Restores the constrained Delaunay property when only the edges in
+    // [first, last) can violate it, e.g. because their constraints were
+    // lifted. The edges that were flipped are appended to flipped.
+    template <typename Edge_input_iterator>
+    void make_cdt (Edge_input_iterator first, Edge_input_iterator last, std::vector<Edge_handle>* flipped = NULL) {
+        boost::unordered_set<Edge_iterator, edge_iterator_hash> edges_to_flip(first, last);
+        flip_non_delaunay_edges(edges_to_flip, flipped);
+    }
+
+    // Moves the node to p, snapped like in add_node, and invalidates the
+    // quality cached in the faces around it. The connectivity is kept, so
+    // the caller has to keep the faces around the node positively
+    // oriented.
+    void move_node (Node_handle n, Point_2 const& p) {
+        n->position() = Kernel::snap(p);
+        if (n->is_isolated()) {
+            return;
+        }
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            if (not he_iter->is_boundary()) {
+                he_iter->face()->invalidate_quality();
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+    }
+
+    // hides Triangulation::insert_in_edge so that the halves of a
+    // constrained edge stay constrained and the new faces keep the regions
+    // of the faces they replace
+    Node_handle insert_in_edge (Edge_handle e, Point_2 const& p) {
+        Node_handle n1 = e->he1()->origin();
+        Node_handle n2 = e->he2()->origin();
+        Node_handle n3 = e->he1()->is_boundary() ? Node_handle() : e->he1()->prev()->origin();
+        int region1 = e->he1()->is_boundary() ? 0 : e->he1()->face()->region();
+        int region2 = e->he2()->is_boundary() ? 0 : e->he2()->face()->region();
+        bool constrained = e->is_marked_constrained();
+
+        Node_handle n = Base::insert_in_edge(e, p);
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            Node_handle dest = he_iter->pair()->origin();
+            if (dest == n1 || dest == n2) {
+                he_iter->edge()->set_constrained(constrained);
+            }
+            if (not he_iter->is_boundary()) {
+                Node_handle opposite = he_iter->prev()->origin();
+                bool first_side = dest == n3 || opposite == n3;
+                he_iter->face()->set_region(first_side ? region1 : region2);
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        return n;
+    }
+
+    Node_handle insert_in_face (Face_handle f, Point_2 const& p) {
+        int region = f->region();
+        Node_handle n = Base::insert_in_face(f, p);
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            he_iter->face()->set_region(region);
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        return n;
+    }
+
+    // Makes the segment between two nodes a constrained edge. Edges crossing
+    // the segment are flipped away as proposed by Sloan and nodes lying on
+    // the segment split it into several constrained edges. The segment must
+    // lie inside of the triangulation and must not cross other constrained
+    // edges. Call make_cdt afterwards to restore the Delaunay property of
+    // the other edges.
+    void insert_constraint (Node_handle a, Node_handle b) {
+        while (a != b) {
+            std::list<Edge_handle> crossing;
+            Node_handle c = find_crossing_edges(a, b, crossing);
+            Point_2 pa = a->position();
+            Point_2 pc = c->position();
+            while (not crossing.empty()) {
+                Edge_handle e = crossing.front();
+                crossing.pop_front();
+                if (not e->is_flippable()) {
+                    crossing.push_back(e);
+                    continue;
+                }
+                e->flip();
+                Point_2 p1, p2;
+                e->vertices(p1, p2);
+                typename Kernel::Oriented_side os1 = Kernel::oriented_side(pa, pc, p1);
+                typename Kernel::Oriented_side os2 = Kernel::oriented_side(pa, pc, p2);
+                if (os1 != Kernel::ON_ORIENTED_BOUNDARY && os2 != Kernel::ON_ORIENTED_BOUNDARY && os1 != os2) {
+                    crossing.push_back(e);
+                }
+            }
+            Halfedge_handle he = find_halfedge(a, c);
+            BOOST_ASSERT(he != Halfedge_handle());
+            he->edge()->set_constrained(true);
+            a = c;
+        }
+    }
+
+    // inserts the end points of the segment into the triangulation first
+    void insert_constraint (Point_2 const& p, Point_2 const& q) {
+        Node_handle a = node_at(p);
+        Node_handle b = node_at(q);
+        insert_constraint(a, b);
+    }
+
+    // Sets the region of all faces that can be reached from the face
+    // containing the seed point without crossing a constrained edge.
+    void mark_region (Point_2 const& seed, int region) {
+        Point_location loc;
+        Node_handle n;
+        Edge_handle e;
+        Face_handle f = this->locate(seed, loc, n, e);
+        if (loc != IN_FACE) {
+            throw region_error();
+        }
+        boost::unordered_set<Face_handle, face_handle_hash> visited;
+        std::stack<Face_handle> faces;
+        faces.push(f);
+        visited.insert(f);
+        while (not faces.empty()) {
+            f = faces.top();
+            faces.pop();
+            f->set_region(region);
+            Halfedge_handle he = f->halfedge();
+            for (int i = 0; i < 3; ++i, he = he->next()) {
+                if (not he->edge()->is_constrained() && visited.insert(he->pair()->face()).second) {
+                    faces.push(he->pair()->face());
+                }
+            }
+        }
+    }
+
+    struct constraint_error : virtual umeshu_error { };
+    struct region_error : virtual umeshu_error { };
+
+private:
+    template <typename Edge_set>
+    void flip_non_delaunay_edges (Edge_set& edges_to_flip, std::vector<Edge_handle>* flipped) {
+        size_t flips = 0;
         while (not edges_to_flip.empty()) {
             Edge_handle e = *edges_to_flip.begin();
             edges_to_flip.erase(edges_to_flip.begin());
             if (not e->is_flippable() || e->is_delaunay())
                 continue;
+            if (not Kernel::has_exact_predicates && ++flips > this->number_of_edges()*this->number_of_edges()) {
+                throw topology_error();
+            }
             Halfedge_handle he = e->he1();
             edges_to_flip.insert(he->next()->edge());
             edges_to_flip.insert(he->prev()->edge());
             edges_to_flip.insert(he->pair()->next()->edge());
             edges_to_flip.insert(he->pair()->prev()->edge());
             e->flip();
+            if (flipped != NULL) {
+                flipped->push_back(e);
+            }
         }
     }
 
-private:
+    Node_handle node_at (Point_2 const& p) {
+        Point_location loc;
+        Node_handle n;
+        Edge_handle e;
+        Face_handle f = this->locate(p, loc, n, e);
+        switch (loc) {
+            case ON_NODE:
+                return n;
+            case ON_EDGE:
+                return insert_in_edge(e, p);
+            case IN_FACE:
+                return insert_in_face(f, p);
+            default:
+                throw constraint_error();
+        }
+    }
+
+    Halfedge_handle find_halfedge (Node_handle from, Node_handle to) const {
+        Halfedge_handle he_start = from->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            if (he_iter->pair()->origin() == to) {
+                return he_iter;
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        return Halfedge_handle();
+    }
+
+    // Collects the edges crossed by the segment from a towards b up to the
+    // first node that lies on the segment, which is returned.
+    Node_handle find_crossing_edges (Node_handle a, Node_handle b, std::list<Edge_handle>& crossing) const {
+        Point_2 pa = a->position();
+        Point_2 pb = b->position();
+
+        Halfedge_handle he_start = a->halfedge();
+        Halfedge_handle he_iter = he_start;
+        Halfedge_handle he;
+        do {
+            Node_handle n = he_iter->pair()->origin();
+            Point_2 p = n->position();
+            typename Kernel::Oriented_side os = Kernel::oriented_side(pa, pb, p);
+            if (n == b || (os == Kernel::ON_ORIENTED_BOUNDARY &&
+                           (p.x()-pa.x())*(pb.x()-pa.x()) + (p.y()-pa.y())*(pb.y()-pa.y()) > 0.0))
+            {
+                return n;
+            }
+            if (not he_iter->is_boundary() && os == Kernel::ON_NEGATIVE_SIDE &&
+                Kernel::oriented_side(pa, pb, he_iter->prev()->origin()->position()) == Kernel::ON_POSITIVE_SIDE)
+            {
+                he = he_iter->next();
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+
+        if (he == Halfedge_handle()) {
+            throw constraint_error();
+        }
+        while (true) {
+            if (he->edge()->is_constrained()) {
+                throw constraint_error();
+            }
+            crossing.push_back(he->edge());
+            Halfedge_handle hep = he->pair();
+            Node_handle v = hep->prev()->origin();
+            if (v == b) {
+                return b;
+            }
+            typename Kernel::Oriented_side os = Kernel::oriented_side(pa, pb, v->position());
+            if (os == Kernel::ON_ORIENTED_BOUNDARY) {
+                return v;
+            }
+            he = os == Kernel::ON_NEGATIVE_SIDE ? hep->prev() : hep->next();
+        }
+    }
+
+    struct face_handle_hash {
+        size_t operator()(Face_handle f) const
+        {
+            return boost::hash<Face*>()(&(*f));
+        }
+    };
+
     struct edge_iterator_hash {
         size_t operator()(Edge_iterator e) const 
         { 
@@ -25,6 +25,8 @@
 #include "Exact_adaptive_kernel.h"
 #include "Triangulation_items.h"
 
+#include <algorithm>
+
 namespace umeshu {
 
 template <typename Kernel, typename HDS>
@@ -79,6 +81,7 @@ public:
 
     Delaunay_triangulation_edge_base(Halfedge_handle g, Halfedge_handle h)
         : Base(g, h)
+        , constrained_(false)
     {}
 
     Point_2 midpoint() const {
@@ -95,10 +98,17 @@ public:
         return dot_p < 0.0;
     }
 
+    // boundary edges are always constrained, interior edges are constrained
+    // when they separate regions or were inserted as constraints
     bool is_constrained() const {
-        return this->is_boundary();
+        return constrained_ || this->is_boundary();
     }
 
+    void set_constrained(bool constrained) { constrained_ = constrained; }
+
+    // whether the edge was marked constrained, regardless of the boundary
+    bool is_marked_constrained() const { return constrained_; }
+
     bool is_delaunay() const {
         if (this->is_constrained()) {
             return true;
@@ -114,6 +124,17 @@ public:
         }
         return true;
     }
+
+    // hides Triangulation_edge_base::flip() so that the quality cached in
+    // the two faces of the edge is invalidated when their vertices change
+    void flip () {
+        Base::flip();
+        this->he1()->face()->invalidate_quality();
+        this->he2()->face()->invalidate_quality();
+    }
+
+private:
+    bool constrained_;
 };
 
 template <typename Kernel, typename HDS>
@@ -131,6 +152,54 @@ public:
     typedef typename Base::Face_handle           Face_handle;
     typedef typename Base::Face_const_handle     Face_const_handle;
 
+    Delaunay_triangulation_face_base()
+        : Base()
+        , quality_is_valid_(false)
+        , area_(0.0)
+        , min_angle_sine_squared_(0.0)
+        , region_(0)
+    {}
+
+    // Area of the face and squared sine of its smallest angle. Both are
+    // computed without square roots and trigonometric functions and cached
+    // in the face until its vertices change.
+    double area() const {
+        update_quality();
+        return area_;
+    }
+
+    double min_angle_sine_squared() const {
+        update_quality();
+        return min_angle_sine_squared_;
+    }
+
+    void invalidate_quality() { quality_is_valid_ = false; }
+
+    // region of the domain that the face belongs to, see
+    // Delaunay_triangulation::mark_region
+    int region() const { return region_; }
+    void set_region(int region) { region_ = region; }
+
+private:
+    void update_quality() const {
+        if (quality_is_valid_) {
+            return;
+        }
+        Point_2 p1, p2, p3;
+        this->vertices(p1, p2, p3);
+        double a2 = Kernel::distance_squared(p2, p3);
+        double b2 = Kernel::distance_squared(p3, p1);
+        double c2 = Kernel::distance_squared(p1, p2);
+        double twice_area = (p2.x()-p1.x())*(p3.y()-p1.y()) - (p2.y()-p1.y())*(p3.x()-p1.x());
+        area_ = 0.5*twice_area;
+        min_angle_sine_squared_ = Kernel::min_angle_sine_squared(twice_area, a2, b2, c2);
+        quality_is_valid_ = true;
+    }
+
+    mutable bool   quality_is_valid_;
+    mutable double area_;
+    mutable double min_angle_sine_squared_;
+    int            region_;
 };
 
 struct Delaunay_triangulation_items {
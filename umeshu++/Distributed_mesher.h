@@ -0,0 +1,408 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __DISTRIBUTED_MESHER_H_INCLUDED__
+#define __DISTRIBUTED_MESHER_H_INCLUDED__ 
+
+#include "Domain_decomposition_mesher.h"
+
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/nonblocking.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/unordered/unordered_map.hpp>
+#include <boost/unordered/unordered_set.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace umeshu {
+
+// Refines a mesh across the processes of an MPI communicator, one part of
+// the domain decomposition per process. The root process partitions the
+// mesh, splits the separators at their midpoints and sends every other
+// process its subdomain. Each process then refines its subdomain in rounds
+// in which the separators are split like the boundary, e.g. when a Steiner
+// point encroaches upon them, and the processes sharing a separator send
+// each other the points they split it at and insert the points received.
+// The rounds end when no process splits or receives anything, so both
+// sides of every separator have the same nodes. No separator is encroached
+// upon from either side then, which makes the subdomains together a
+// conforming Delaunay mesh, and every process keeps its refined subdomain
+// in the mesh passed to refine, e.g. to write it out itself.
+template <typename Delaunay_triangulation, typename Quality = Delaunay_mesh_area_quality<Delaunay_triangulation> >
+class Distributed_mesher : public Domain_decomposition_mesher<Delaunay_triangulation, Quality> {
+public:
+    typedef          Domain_decomposition_mesher<Delaunay_triangulation, Quality> Base;
+    typedef          Delaunay_triangulation      Tria;
+    typedef typename Tria::Kernel                Kernel;
+    typedef typename Kernel::Point_2             Point_2;
+
+    typedef typename Tria::Node                  Node;
+    typedef typename Tria::Edge                  Edge;
+
+    typedef typename Tria::Node_handle           Node_handle;
+    typedef typename Tria::Halfedge_handle       Halfedge_handle;
+    typedef typename Tria::Edge_handle           Edge_handle;
+    typedef typename Tria::Face_handle           Face_handle;
+
+    typedef typename Base::Mesher                Mesher;
+
+    explicit Distributed_mesher (boost::mpi::communicator const& comm, int root = 0)
+        : Base(comm.size())
+        , comm_(comm)
+        , root_(root)
+        , rounds_(0)
+    {}
+
+    // number of rounds of refinement and exchange of the last refine
+    size_t rounds () const { return rounds_; }
+
+    // The mesh is only read on the root process. Every process ends up with
+    // its refined subdomain in the mesh, bounded by the domain boundary and
+    // the separators.
+    void refine (Delaunay_triangulation& mesh, double max_area, double min_angle) {
+        this->max_area_ = max_area;
+        this->min_angle_ = min_angle;
+
+        int rank = comm_.rank();
+        Subdomain_data data;
+        if (rank == root_) {
+            this->partition(mesh);
+            Separator_ids ids;
+            for (int i = 0; i < comm_.size(); ++i) {
+                this->prepare_subdomain(i);
+                std::vector<int> numbers = number_separators(this->subdomains_[i], ids);
+                if (i == root_) {
+                    separator_ids_.swap(numbers);
+                } else {
+                    pack(this->subdomains_[i], numbers, data);
+                    comm_.send(i, 0, data);
+                    this->subdomains_[i].mesh.clear();
+                }
+            }
+        } else {
+            this->subdomains_.clear();
+            for (int i = 0; i < comm_.size(); ++i) {
+                this->subdomains_.push_back(new typename Base::Subdomain);
+            }
+            comm_.recv(root_, 0, data);
+            unpack(data, this->subdomains_[rank]);
+        }
+
+        typename Base::Subdomain& sub = this->subdomains_[rank];
+        std::vector<bool> forward;
+        for (size_t k = 0; k < sub.separators.size(); ++k) {
+            typename Base::Separator const& s = sub.separators[k];
+            forward.push_back(Base::find_halfedge(s.nodes[0], s.nodes[1])->is_boundary());
+        }
+        rounds_ = 0;
+        bool changed = true;
+        while (changed) {
+            ++rounds_;
+            changed = refine_and_exchange(sub, forward);
+            changed = boost::mpi::all_reduce(comm_, changed, std::logical_or<bool>());
+        }
+
+        mesh.clear();
+        mesh.splice(sub.mesh);
+        this->subdomains_.clear();
+        this->part_of_.clear();
+        this->part_faces_.clear();
+    }
+
+private:
+    // Subdomain flattened into arrays of node coordinates, node indices and
+    // regions of the faces, node indices of the constrained edges and, for
+    // every separator, its number, the part on the other side, the number of
+    // its nodes and their indices
+    struct Subdomain_data {
+        std::vector<double> coordinates;
+        std::vector<int>    faces;
+        std::vector<int>    regions;
+        std::vector<int>    constrained;
+        std::vector<int>    separators;
+
+        template <typename Archive>
+        void serialize (Archive& ar, unsigned int /* version */) {
+            ar & coordinates & faces & regions & constrained & separators;
+        }
+    };
+
+    typedef boost::unordered_map<Node const*, int> Node_indices;
+    typedef boost::unordered_map<Edge const*, int> Separator_ids;
+    typedef boost::unordered_set<Node const*>      Node_set;
+    // points on separators sent to a process, as the number of the
+    // separator, the number of points and their coordinates
+    typedef std::map<unsigned, std::vector<double> > Messages;
+
+    // The processes sharing a separator know it by the same number, which
+    // replaces the edge of the original mesh as its key.
+    static std::vector<int> number_separators (typename Base::Subdomain const& sub, Separator_ids& ids) {
+        std::vector<int> numbers;
+        for (size_t k = 0; k < sub.separators.size(); ++k) {
+            int id = ids.size();
+            numbers.push_back(ids.insert(std::make_pair(sub.separators[k].edge, id)).first->second);
+        }
+        return numbers;
+    }
+
+    // Refines the subdomain with the separators split like the boundary,
+    // sends the new points on the separators to the processes on the other
+    // side and inserts the points received from them. Returns whether the
+    // subdomain changed.
+    bool refine_and_exchange (typename Base::Subdomain& sub, std::vector<bool> const& forward) {
+        size_t number_of_nodes = sub.mesh.number_of_nodes();
+        Mesher mesher;
+        this->configure(mesher);
+        mesher.refine(sub.mesh, this->max_area_, this->min_angle_);
+        bool changed = false;
+
+        Messages outgoing;
+        for (size_t k = 0; k < sub.separators.size(); ++k) {
+            typename Base::Separator& s = sub.separators[k];
+            outgoing[s.neighbour];
+            if (sub.mesh.number_of_nodes() == number_of_nodes) {
+                continue;
+            }
+            Node_set old_nodes;
+            for (size_t i = 0; i < s.nodes.size(); ++i) {
+                old_nodes.insert(&*s.nodes[i]);
+            }
+            collect_separator_nodes(s, forward[k]);
+            std::vector<double> points;
+            for (size_t i = 0; i < s.nodes.size(); ++i) {
+                if (old_nodes.find(&*s.nodes[i]) == old_nodes.end()) {
+                    points.push_back(s.nodes[i]->position().x());
+                    points.push_back(s.nodes[i]->position().y());
+                }
+            }
+            if (not points.empty()) {
+                std::vector<double>& message = outgoing[s.neighbour];
+                message.push_back(separator_ids_[k]);
+                message.push_back(points.size()/2);
+                message.insert(message.end(), points.begin(), points.end());
+                changed = true;
+            }
+        }
+
+        std::vector<boost::mpi::request> requests;
+        for (typename Messages::const_iterator iter = outgoing.begin(); iter != outgoing.end(); ++iter) {
+            requests.push_back(comm_.isend(iter->first, 1, iter->second));
+        }
+        typedef boost::unordered_map<int, size_t> Separator_indices;
+        Separator_indices indices;
+        for (size_t k = 0; k < sub.separators.size(); ++k) {
+            indices[separator_ids_[k]] = k;
+        }
+        for (typename Messages::const_iterator iter = outgoing.begin(); iter != outgoing.end(); ++iter) {
+            std::vector<double> incoming;
+            comm_.recv(iter->first, 1, incoming);
+            for (size_t i = 0; i < incoming.size(); ) {
+                typename Base::Separator& s = sub.separators[indices[static_cast<int>(incoming[i])]];
+                size_t n = static_cast<size_t>(incoming[i+1]);
+                std::vector<Point_2> points;
+                for (size_t j = 0; j < n; ++j) {
+                    points.push_back(Point_2(incoming[i+2+2*j], incoming[i+3+2*j]));
+                }
+                i += 2 + 2*n;
+                changed = insert_separator_nodes(sub.mesh, s, points) || changed;
+            }
+        }
+        boost::mpi::wait_all(requests.begin(), requests.end());
+        return changed;
+    }
+
+    // Collects the nodes of a separator in order after the mesher split it.
+    // The separator runs along the boundary of the subdomain from its first
+    // to its last node, the boundary halfedges pointing from the first
+    // towards the last node if forward. At a first node where the boundary
+    // passes more than once, the halfedge that points closest to the last
+    // node is taken.
+    static void collect_separator_nodes (typename Base::Separator& s, bool forward) {
+        Node_handle first = s.nodes.front();
+        Node_handle last = s.nodes.back();
+        Point_2 const& p = first->position();
+        double dx = last->position().x() - p.x();
+        double dy = last->position().y() - p.y();
+        Halfedge_handle start;
+        double best = -1.0;
+        Halfedge_handle he_start = first->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            Halfedge_handle he = forward ? he_iter : he_iter->pair();
+            if (he->is_boundary()) {
+                Point_2 const& q = he_iter->pair()->origin()->position();
+                double ex = q.x() - p.x();
+                double ey = q.y() - p.y();
+                double cosine = (dx*ex + dy*ey)/std::sqrt((dx*dx + dy*dy)*(ex*ex + ey*ey));
+                if (cosine > best) {
+                    best = cosine;
+                    start = he;
+                }
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        BOOST_ASSERT(start != Halfedge_handle());
+
+        s.nodes.resize(1);
+        Halfedge_handle he = start;
+        while (s.nodes.back() != last) {
+            s.nodes.push_back(forward ? he->pair()->origin() : he->origin());
+            he = forward ? he->next() : he->prev();
+        }
+    }
+
+    // Splits the separator at the points received from the other side that
+    // it does not have yet and restores the Delaunay property around them.
+    static bool insert_separator_nodes (Tria& mesh, typename Base::Separator& s, std::vector<Point_2> const& points) {
+        Point_2 const& p = s.nodes.front()->position();
+        double dx = s.nodes.back()->position().x() - p.x();
+        double dy = s.nodes.back()->position().y() - p.y();
+        std::vector<std::pair<double, Point_2> > sorted;
+        for (size_t i = 0; i < points.size(); ++i) {
+            sorted.push_back(std::make_pair((points[i].x() - p.x())*dx + (points[i].y() - p.y())*dy, points[i]));
+        }
+        std::sort(sorted.begin(), sorted.end(), Parameter_less());
+
+        std::vector<Node_handle> nodes;
+        std::vector<Edge_handle> link;
+        size_t i = 0;
+        for (size_t j = 0; j + 1 < s.nodes.size(); ++j) {
+            Node_handle a = s.nodes[j];
+            Node_handle b = s.nodes[j+1];
+            nodes.push_back(a);
+            double tb = (b->position().x() - p.x())*dx + (b->position().y() - p.y())*dy;
+            for (; i < sorted.size() && sorted[i].first < tb; ++i) {
+                if (sorted[i].second == a->position()) {
+                    continue;
+                }
+                Node_handle n = mesh.insert_in_edge(Base::find_halfedge(a, b)->edge(), sorted[i].second);
+                nodes.push_back(n);
+                collect_link(n, link);
+                a = n;
+            }
+        }
+        nodes.push_back(s.nodes.back());
+        bool changed = nodes.size() != s.nodes.size();
+        s.nodes.swap(nodes);
+        mesh.make_cdt(link.begin(), link.end());
+        return changed;
+    }
+
+    static void collect_link (Node_handle n, std::vector<Edge_handle>& link) {
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            if (not he_iter->is_boundary()) {
+                link.push_back(he_iter->next()->edge());
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+    }
+
+    struct Parameter_less {
+        bool operator() (std::pair<double, Point_2> const& p1, std::pair<double, Point_2> const& p2) const {
+            return p1.first < p2.first;
+        }
+    };
+
+    static void pack (typename Base::Subdomain const& sub, std::vector<int> const& numbers, Subdomain_data& data) {
+        data.coordinates.clear();
+        data.faces.clear();
+        data.regions.clear();
+        data.constrained.clear();
+        data.separators.clear();
+
+        Node_indices indices;
+        for (typename Tria::Node_const_iterator iter = sub.mesh.nodes_begin(); iter != sub.mesh.nodes_end(); ++iter) {
+            indices[&*iter] = data.coordinates.size()/2;
+            data.coordinates.push_back(iter->position().x());
+            data.coordinates.push_back(iter->position().y());
+        }
+        for (typename Tria::Face_const_iterator iter = sub.mesh.faces_begin(); iter != sub.mesh.faces_end(); ++iter) {
+            typename Tria::Node_const_handle n1, n2, n3;
+            iter->nodes(n1, n2, n3);
+            data.faces.push_back(indices[&*n1]);
+            data.faces.push_back(indices[&*n2]);
+            data.faces.push_back(indices[&*n3]);
+            data.regions.push_back(iter->region());
+        }
+        for (typename Tria::Edge_const_iterator iter = sub.mesh.edges_begin(); iter != sub.mesh.edges_end(); ++iter) {
+            if (iter->is_marked_constrained()) {
+                data.constrained.push_back(indices[&*iter->he1()->origin()]);
+                data.constrained.push_back(indices[&*iter->he2()->origin()]);
+            }
+        }
+        for (size_t k = 0; k < sub.separators.size(); ++k) {
+            typename Base::Separator const& s = sub.separators[k];
+            data.separators.push_back(numbers[k]);
+            data.separators.push_back(s.neighbour);
+            data.separators.push_back(s.nodes.size());
+            for (size_t i = 0; i < s.nodes.size(); ++i) {
+                data.separators.push_back(indices[&*s.nodes[i]]);
+            }
+        }
+    }
+
+    void unpack (Subdomain_data const& data, typename Base::Subdomain& sub) {
+        sub.mesh.clear();
+        sub.separators.clear();
+        separator_ids_.clear();
+
+        std::vector<Node_handle> nodes;
+        for (size_t i = 0; i < data.coordinates.size(); i += 2) {
+            nodes.push_back(sub.mesh.add_node(Point_2(data.coordinates[i], data.coordinates[i+1])));
+        }
+        for (size_t i = 0; i < data.faces.size(); i += 3) {
+            Face_handle f = Base::add_face(sub.mesh, nodes[data.faces[i]], nodes[data.faces[i+1]], nodes[data.faces[i+2]]);
+            f->set_region(data.regions[i/3]);
+        }
+        for (size_t i = 0; i < data.constrained.size(); i += 2) {
+            Base::find_halfedge(nodes[data.constrained[i]], nodes[data.constrained[i+1]])->edge()->set_constrained(true);
+        }
+        for (size_t i = 0; i < data.separators.size(); ) {
+            typename Base::Separator s;
+            s.edge = NULL;
+            separator_ids_.push_back(data.separators[i++]);
+            s.neighbour = data.separators[i++];
+            s.nodes.resize(data.separators[i++]);
+            for (size_t j = 0; j < s.nodes.size(); ++j) {
+                s.nodes[j] = nodes[data.separators[i++]];
+            }
+            sub.separators.push_back(s);
+        }
+    }
+
+    boost::mpi::communicator comm_;
+    int                      root_;
+    size_t                   rounds_;
+    // numbers of the separators of the subdomain of this process
+    std::vector<int>         separator_ids_;
+};
+
+} // namespace umeshu
+
+#endif /* __DISTRIBUTED_MESHER_H_INCLUDED__ */
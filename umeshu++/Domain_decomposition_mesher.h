@@ -0,0 +1,533 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __DOMAIN_DECOMPOSITION_MESHER_H_INCLUDED__
+#define __DOMAIN_DECOMPOSITION_MESHER_H_INCLUDED__ 
+
+#include "Delaunay_mesher.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/unordered/unordered_map.hpp>
+#include <boost/unordered/unordered_set.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace umeshu {
+
+// Refines a mesh by splitting it into subdomains that are refined
+// independently, each by its own Delaunay_mesher in its own thread. The
+// faces are partitioned by recursive bisection of their centroids, balanced
+// by area. The edges separating the subdomains become boundary edges of the
+// subdomains and are split at their midpoints down to the size implied by
+// the area bound. Both sides of a separator are split identically, the
+// separators are kept fixed during the refinement of the subdomains, and
+// so the subdomains can be stitched back along them: the elements of the
+// subdomains are moved into the mesh and only the faces around the
+// duplicate nodes on the separators are rebuilt. A final serial pass
+// restores the Delaunay property across the separators and refines the
+// faces along them and the faces that the fixed separators left bad.
+// Interior constrained edges and the regions of the faces are carried over
+// to the subdomains and back.
+template <typename Delaunay_triangulation, typename Quality = Delaunay_mesh_area_quality<Delaunay_triangulation> >
+class Domain_decomposition_mesher {
+public:
+    typedef          Delaunay_triangulation      Tria;
+    typedef typename Tria::Kernel                Kernel;
+    typedef typename Kernel::Point_2             Point_2;
+
+    typedef typename Tria::Node                  Node;
+    typedef typename Tria::Halfedge              Halfedge;
+    typedef typename Tria::Edge                  Edge;
+    typedef typename Tria::Face                  Face;
+
+    typedef typename Tria::Face_iterator         Face_iterator;
+
+    typedef typename Tria::Node_handle           Node_handle;
+    typedef typename Tria::Halfedge_handle       Halfedge_handle;
+    typedef typename Tria::Edge_handle           Edge_handle;
+    typedef typename Tria::Face_handle           Face_handle;
+
+    typedef          Delaunay_mesher<Delaunay_triangulation, Quality> Mesher;
+    typedef typename Mesher::Steiner_point       Steiner_point;
+    typedef typename Mesher::Sizing_field        Sizing_field;
+
+    explicit Domain_decomposition_mesher (unsigned number_of_parts = 0)
+        : number_of_parts_(number_of_parts)
+        , coarse_faces_per_part_(32)
+        , steiner_point_(Mesher::CIRCUMCENTER)
+        , max_area_(1.0)
+        , min_angle_(20.0)
+    {
+        if (number_of_parts_ == 0) {
+            number_of_parts_ = std::max(1u, boost::thread::hardware_concurrency());
+        }
+    }
+
+    unsigned number_of_parts () const { return number_of_parts_; }
+
+    void set_steiner_point (Steiner_point sp) { steiner_point_ = sp; }
+    Steiner_point steiner_point () const { return steiner_point_; }
+
+    void set_sizing_field (Sizing_field const& sizing_field) { sizing_field_ = sizing_field; }
+    Sizing_field const& sizing_field () const { return sizing_field_; }
+
+    // see Delaunay_mesher::set_region_max_area
+    void set_region_max_area (int region, double max_area) { region_max_areas_[region] = max_area; }
+    void clear_region_max_areas () { region_max_areas_.clear(); }
+
+    void refine (Delaunay_triangulation& mesh, double max_area, double min_angle) {
+        max_area_ = max_area;
+        min_angle_ = min_angle;
+
+        partition(mesh);
+        if (number_of_parts_ == 1) {
+            refine_subdomain(0);
+        } else {
+            boost::thread_group workers;
+            for (unsigned i = 0; i < number_of_parts_; ++i) {
+                workers.create_thread(boost::bind(&Domain_decomposition_mesher::refine_subdomain, this, i));
+            }
+            workers.join_all();
+        }
+        finish(mesh);
+    }
+
+protected:
+    struct Face_record {
+        Face_handle face;
+        Point_2     centroid;
+        double      area;
+    };
+
+    struct Centroid_less {
+        explicit Centroid_less (int axis) : axis_(axis) {}
+        bool operator() (Face_record const& r1, Face_record const& r2) const {
+            return r1.centroid.coord()[axis_] < r2.centroid.coord()[axis_];
+        }
+        int axis_;
+    };
+
+    // An edge of the original mesh between two parts, the part on the other
+    // side and the nodes that split the edge in a subdomain, ordered from
+    // the origin of he1 of the edge.
+    struct Separator {
+        Edge const*              edge;
+        unsigned                 neighbour;
+        std::vector<Node_handle> nodes;
+    };
+
+    // Faces of one part refined independently of the others. The
+    // separators are the fixed boundary edges shared with other parts.
+    // Corners are the nodes on the boundary of the subdomain that copy the
+    // nodes of the original mesh.
+    struct Subdomain {
+        Tria                     mesh;
+        std::vector<Separator>   separators;
+        std::vector<Edge_handle> pieces;
+        std::vector<std::pair<Node_handle, Node const*> > corners;
+        std::vector<Face_handle> bad_faces;
+    };
+
+    // a face removed while stitching, to be added again between other nodes
+    struct Stitched_face {
+        Node_handle nodes[3];
+        bool        constrained[3];
+        int         region;
+    };
+
+    typedef std::vector<Face_record>                          Face_records;
+    typedef boost::unordered_map<Face const*, unsigned>       Face_parts;
+    typedef boost::unordered_map<Halfedge const*, Node_handle> Corner_nodes;
+    typedef boost::unordered_map<Node const*, Node_handle>     Merged_nodes;
+    typedef boost::unordered_map<Edge const*, std::vector<Node_handle> const*> Separator_nodes;
+    typedef boost::unordered_set<Face const*>                 Face_set;
+    typedef std::map<int, double>                             Region_max_areas;
+
+    // Assigns the faces of the mesh to parts and creates an empty subdomain
+    // for every part.
+    void partition (Delaunay_triangulation& mesh) {
+        // a coarse triangulation of the domain consists of few long faces
+        // that cannot be partitioned evenly, so it is first refined serially
+        // to a handful of faces per subdomain
+        if (mesh.number_of_faces() < number_of_parts_*coarse_faces_per_part_) {
+            double area = 0.0;
+            for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+                area += iter->area();
+            }
+            Mesher mesher;
+            mesher.set_steiner_point(steiner_point_);
+            mesher.refine(mesh, std::max(max_area_, area/(number_of_parts_*coarse_faces_per_part_)), min_angle_);
+        }
+
+        Face_records records;
+        records.reserve(mesh.number_of_faces());
+        for (Face_iterator iter = mesh.faces_begin(); iter != mesh.faces_end(); ++iter) {
+            Point_2 p1, p2, p3;
+            iter->vertices(p1, p2, p3);
+            Face_record r;
+            r.face = iter;
+            r.centroid = Kernel::barycenter(p1, p2, p3);
+            r.area = iter->area();
+            records.push_back(r);
+        }
+        part_of_.clear();
+        part_faces_.assign(number_of_parts_, std::vector<Face_handle>());
+        bisect(records, 0, records.size(), 0, number_of_parts_);
+
+        subdomains_.clear();
+        for (unsigned i = 0; i < number_of_parts_; ++i) {
+            subdomains_.push_back(new Subdomain);
+        }
+    }
+
+    // Stitches the refined subdomains into the mesh and refines the faces
+    // along the separators.
+    void finish (Delaunay_triangulation& mesh) {
+        std::vector<Edge_handle> separators;
+        std::vector<Face_handle> faces;
+        stitch(mesh, separators, faces);
+        subdomains_.clear();
+        part_of_.clear();
+        part_faces_.clear();
+
+        std::vector<Edge_handle> flipped;
+        mesh.make_cdt(separators.begin(), separators.end(), &flipped);
+        flipped.insert(flipped.end(), separators.begin(), separators.end());
+        for (typename std::vector<Edge_handle>::iterator iter = flipped.begin(); iter != flipped.end(); ++iter) {
+            faces.push_back((*iter)->he1()->face());
+            faces.push_back((*iter)->he2()->face());
+        }
+        Mesher mesher;
+        configure(mesher);
+        mesher.refine_faces(mesh, faces, max_area_, min_angle_);
+    }
+
+    // splits the faces along the wider extent of their centroids so that
+    // both halves have areas proportional to their numbers of parts
+    void bisect (Face_records& records, size_t first, size_t last, unsigned first_part, unsigned parts) {
+        if (parts == 1 || last - first < 2) {
+            for (size_t i = first; i < last; ++i) {
+                part_of_[&*records[i].face] = first_part;
+                part_faces_[first_part].push_back(records[i].face);
+            }
+            return;
+        }
+
+        Point_2 lower = records[first].centroid;
+        Point_2 upper = lower;
+        double area = 0.0;
+        for (size_t i = first; i < last; ++i) {
+            Point_2 const& c = records[i].centroid;
+            lower = Point_2(std::min(lower.x(), c.x()), std::min(lower.y(), c.y()));
+            upper = Point_2(std::max(upper.x(), c.x()), std::max(upper.y(), c.y()));
+            area += records[i].area;
+        }
+        int axis = upper.x() - lower.x() >= upper.y() - lower.y() ? 0 : 1;
+        std::sort(records.begin() + first, records.begin() + last, Centroid_less(axis));
+
+        unsigned left_parts = parts/2;
+        double left_area = area*left_parts/parts;
+        size_t middle = first + 1;
+        double accumulated = records[first].area;
+        while (middle < last - 1 && accumulated < left_area) {
+            accumulated += records[middle].area;
+            ++middle;
+        }
+        bisect(records, first, middle, first_part, left_parts);
+        bisect(records, middle, last, first_part + left_parts, parts - left_parts);
+    }
+
+    void configure (Mesher& mesher) const {
+        mesher.set_steiner_point(steiner_point_);
+        mesher.set_sizing_field(sizing_field_);
+        for (typename Region_max_areas::const_iterator iter = region_max_areas_.begin(); iter != region_max_areas_.end(); ++iter) {
+            mesher.set_region_max_area(iter->first, iter->second);
+        }
+    }
+
+    bool is_in_part (Face_handle f, unsigned part) const {
+        return f != Face_handle() && part_of_.find(&*f)->second == part;
+    }
+
+    // Runs in its own thread and only reads the original mesh.
+    void refine_subdomain (unsigned part) {
+        prepare_subdomain(part);
+        refine_prepared_subdomain(subdomains_[part]);
+    }
+
+    // Copies the faces of the part into its subdomain and splits the
+    // separators.
+    void prepare_subdomain (unsigned part) {
+        Subdomain& sub = subdomains_[part];
+        extract(part, sub);
+
+        for (typename std::vector<Separator>::iterator iter = sub.separators.begin(); iter != sub.separators.end(); ++iter) {
+            Node_handle first = iter->nodes.front();
+            Node_handle last = iter->nodes.back();
+            iter->nodes.pop_back();
+            split_separator(sub.mesh, first, last, *iter, sub.pieces);
+            iter->nodes.push_back(last);
+        }
+        sub.mesh.make_cdt();
+    }
+
+    void refine_prepared_subdomain (Subdomain& sub) {
+        if (sub.mesh.number_of_faces() == 0) {
+            return;
+        }
+        Mesher mesher;
+        configure(mesher);
+        for (typename std::vector<Edge_handle>::iterator iter = sub.pieces.begin(); iter != sub.pieces.end(); ++iter) {
+            mesher.fix_edge(*iter);
+        }
+        mesher.refine(sub.mesh, max_area_, min_angle_);
+        mesher.collect_bad_faces(sub.bad_faces);
+    }
+
+    void extract (unsigned part, Subdomain& sub) const {
+        Corner_nodes corner_nodes;
+        std::vector<Face_handle> const& faces = part_faces_[part];
+        for (typename std::vector<Face_handle>::const_iterator iter = faces.begin(); iter != faces.end(); ++iter) {
+            Halfedge_handle he = (*iter)->halfedge();
+            Node_handle n1 = corner_node(sub, corner_nodes, he, part);
+            Node_handle n2 = corner_node(sub, corner_nodes, he->next(), part);
+            Node_handle n3 = corner_node(sub, corner_nodes, he->prev(), part);
+            Face_handle f = add_face(sub.mesh, n1, n2, n3);
+            f->set_region((*iter)->region());
+
+            Halfedge_handle he_iter = he;
+            Node_handle n_iter = n1, n_next = n2;
+            for (int i = 0; i < 3; ++i) {
+                if (he_iter->edge()->is_marked_constrained()) {
+                    find_halfedge(n_iter, n_next)->edge()->set_constrained(true);
+                }
+                Face_handle g = he_iter->pair()->face();
+                if (g != Face_handle() && not is_in_part(g, part)) {
+                    Separator separator;
+                    separator.edge = &*he_iter->edge();
+                    separator.neighbour = part_of_.find(&*g)->second;
+                    bool forward = he_iter == he_iter->edge()->he1();
+                    separator.nodes.push_back(forward ? n_iter : n_next);
+                    separator.nodes.push_back(forward ? n_next : n_iter);
+                    sub.separators.push_back(separator);
+                }
+                he_iter = he_iter->next();
+                n_iter = n_next;
+                n_next = i == 0 ? n3 : n1;
+            }
+        }
+    }
+
+    // Returns the subdomain node at the origin of a halfedge of a face in
+    // the part. The faces of the part around a node of the original mesh
+    // share the node in the subdomain only if they are connected through
+    // edges, so that the subdomain stays manifold.
+    Node_handle corner_node (Subdomain& sub, Corner_nodes& corner_nodes, Halfedge_handle he, unsigned part) const {
+        typename Corner_nodes::iterator found = corner_nodes.find(&*he);
+        if (found != corner_nodes.end()) {
+            return found->second;
+        }
+        Node_handle n = sub.mesh.add_node(he->origin()->position());
+        Halfedge_handle he_iter = he;
+        do {
+            corner_nodes[&*he_iter] = n;
+            he_iter = he_iter->prev()->pair();
+        } while (he_iter != he && is_in_part(he_iter->face(), part));
+        if (he_iter != he) {
+            he_iter = he->pair()->next();
+            while (is_in_part(he_iter->face(), part)) {
+                corner_nodes[&*he_iter] = n;
+                he_iter = he_iter->pair()->next();
+            }
+            sub.corners.push_back(std::make_pair(n, &*he->origin()));
+        }
+        return n;
+    }
+
+    // The separators are split at their midpoints down to the sides of
+    // equilateral triangles of the maximum area there. The midpoints do not
+    // depend on the orientation of the edge, so that both subdomains sharing
+    // a separator end up with the same nodes on it. The nodes between first
+    // and last are appended to the separator in order.
+    void split_separator (Tria& mesh, Node_handle first, Node_handle last, Separator& separator, std::vector<Edge_handle>& pieces) const {
+        Edge_handle e = find_halfedge(first, last)->edge();
+        Point_2 p1 = first->position();
+        Point_2 p2 = last->position();
+        Point_2 m = Kernel::midpoint(p1, p2);
+        double max_area = sizing_field_.empty() ? max_area_ : std::min(max_area_, sizing_field_(m));
+        if (Kernel::distance_squared(p1, p2) <= 4.0*max_area/std::sqrt(3.0)) {
+            pieces.push_back(e);
+            return;
+        }
+        Node_handle n = mesh.insert_in_edge(e, m);
+        split_separator(mesh, first, n, separator, pieces);
+        separator.nodes.push_back(n);
+        split_separator(mesh, n, last, separator, pieces);
+    }
+
+    // Moves the elements of the refined subdomains into the mesh, which
+    // replace its faces. A node on a separator is kept from the subdomain
+    // that is stitched first and the faces of the other subdomains around
+    // their copies of the node are rebuilt on it, which joins the two sides
+    // of the separator. The nodes are matched through the nodes and edges of
+    // the original mesh they come from. The separators joined and the faces
+    // that may be bad are appended to separators and faces.
+    void stitch (Delaunay_triangulation& mesh, std::vector<Edge_handle>& separators, std::vector<Face_handle>& faces) {
+        Merged_nodes corner_nodes;
+        Separator_nodes separator_nodes;
+        mesh.clear();
+        for (typename boost::ptr_vector<Subdomain>::iterator sub = subdomains_.begin(); sub != subdomains_.end(); ++sub) {
+            Merged_nodes merged_nodes;
+            std::vector<Node_handle> duplicates;
+            for (size_t i = 0; i < sub->corners.size(); ++i) {
+                Node_handle n = sub->corners[i].first;
+                std::pair<typename Merged_nodes::iterator, bool> ins = corner_nodes.insert(std::make_pair(sub->corners[i].second, n));
+                if (ins.first->second != n) {
+                    merged_nodes[&*n] = ins.first->second;
+                    duplicates.push_back(n);
+                }
+            }
+            for (typename std::vector<Separator>::iterator iter = sub->separators.begin(); iter != sub->separators.end(); ++iter) {
+                std::pair<typename Separator_nodes::iterator, bool> ins = separator_nodes.insert(std::make_pair(iter->edge, &iter->nodes));
+                if (ins.second) {
+                    // the other subdomain joins its nodes to these
+                    iter->nodes.front() = merged_node(merged_nodes, iter->nodes.front());
+                    iter->nodes.back() = merged_node(merged_nodes, iter->nodes.back());
+                    continue;
+                }
+                std::vector<Node_handle> const& kept = *ins.first->second;
+                BOOST_ASSERT(kept.size() == iter->nodes.size());
+                for (size_t i = 1; i + 1 < kept.size(); ++i) {
+                    merged_nodes[&*iter->nodes[i]] = kept[i];
+                    duplicates.push_back(iter->nodes[i]);
+                }
+                for (size_t i = 0; i + 1 < kept.size(); ++i) {
+                    separators.push_back(find_halfedge(kept[i], kept[i+1])->edge());
+                }
+            }
+
+            mesh.splice(sub->mesh);
+            Face_set removed;
+            std::vector<Stitched_face> stitched;
+            for (typename std::vector<Node_handle>::const_iterator iter = duplicates.begin(); iter != duplicates.end(); ++iter) {
+                collect_stitched_faces(*iter, merged_nodes, removed, stitched);
+            }
+            for (typename std::vector<Face_handle>::const_iterator iter = sub->bad_faces.begin(); iter != sub->bad_faces.end(); ++iter) {
+                if (removed.find(&**iter) == removed.end()) {
+                    faces.push_back(*iter);
+                }
+            }
+            for (typename std::vector<Node_handle>::const_iterator iter = duplicates.begin(); iter != duplicates.end(); ++iter) {
+                mesh.remove_node(*iter);
+            }
+            for (typename std::vector<Stitched_face>::const_iterator iter = stitched.begin(); iter != stitched.end(); ++iter) {
+                Face_handle f = add_face(mesh, iter->nodes[0], iter->nodes[1], iter->nodes[2]);
+                BOOST_ASSERT(f != Face_handle());
+                f->set_region(iter->region);
+                Halfedge_handle he = f->halfedge();
+                for (int i = 0; i < 3; ++i, he = he->next()) {
+                    if (iter->constrained[i]) {
+                        he->edge()->set_constrained(true);
+                    }
+                }
+                faces.push_back(f);
+            }
+        }
+    }
+
+    static Node_handle merged_node (Merged_nodes const& merged_nodes, Node_handle n) {
+        typename Merged_nodes::const_iterator found = merged_nodes.find(&*n);
+        return found != merged_nodes.end() ? found->second : n;
+    }
+
+    // Records the faces around a duplicate node with their nodes replaced by
+    // the nodes they are merged into.
+    static void collect_stitched_faces (Node_handle n, Merged_nodes const& merged_nodes, Face_set& removed, std::vector<Stitched_face>& stitched) {
+        Halfedge_handle he_start = n->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            Face_handle f = he_iter->face();
+            if (f != Face_handle() && removed.insert(&*f).second) {
+                Stitched_face s;
+                Halfedge_handle he = f->halfedge();
+                for (int i = 0; i < 3; ++i, he = he->next()) {
+                    s.nodes[i] = merged_node(merged_nodes, he->origin());
+                    s.constrained[i] = he->edge()->is_marked_constrained();
+                }
+                s.region = f->region();
+                stitched.push_back(s);
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+    }
+
+    static Halfedge_handle find_halfedge (Node_handle n1, Node_handle n2) {
+        if (n1->is_isolated()) {
+            return Halfedge_handle();
+        }
+        Halfedge_handle he_start = n1->halfedge();
+        Halfedge_handle he_iter = he_start;
+        do {
+            if (he_iter->pair()->origin() == n2) {
+                return he_iter;
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        return Halfedge_handle();
+    }
+
+    static Halfedge_handle find_or_add_halfedge (Tria& mesh, Node_handle n1, Node_handle n2) {
+        Halfedge_handle he = find_halfedge(n1, n2);
+        if (he == Halfedge_handle()) {
+            he = mesh.add_edge(n1, n2);
+        }
+        return he;
+    }
+
+    static Face_handle add_face (Tria& mesh, Node_handle n1, Node_handle n2, Node_handle n3) {
+        Halfedge_handle he1 = find_or_add_halfedge(mesh, n1, n2);
+        Halfedge_handle he2 = find_or_add_halfedge(mesh, n2, n3);
+        Halfedge_handle he3 = find_or_add_halfedge(mesh, n3, n1);
+        return mesh.add_face(he1, he2, he3);
+    }
+
+    unsigned                    number_of_parts_;
+    unsigned                    coarse_faces_per_part_;
+    Steiner_point               steiner_point_;
+    Sizing_field                sizing_field_;
+    Region_max_areas            region_max_areas_;
+    double                      max_area_;
+    double                      min_angle_;
+    Face_parts                  part_of_;
+    std::vector<std::vector<Face_handle> > part_faces_;
+    boost::ptr_vector<Subdomain> subdomains_;
+};
+
+} // namespace umeshu
+
+#endif /* __DOMAIN_DECOMPOSITION_MESHER_H_INCLUDED__ */
@@ -21,31 +21,205 @@
 
 #include "Exact_adaptive_kernel.h"
 
-double orient2d(double const* pa, double const* pb, double const* pc);
-double incircle(double const* pa, double const* pb, double const* pc, double const* pd);
+#include <algorithm>
 
 namespace umeshu {
 
-Exact_adaptive_kernel::Oriented_side Exact_adaptive_kernel::oriented_side (Point2 const& pa, Point2 const& pb, Point2 const& test)
+namespace {
+
+#if defined(__GNUC__)
+// With the vector extensions of GCC and Clang, the filters are written once
+// for the width of the vector registers: four lanes with AVX (see the
+// UMESHU_WITH_AVX2 build option), two with SSE2.
+#if defined(__AVX__)
+size_t const lanes = 4;
+#else
+size_t const lanes = 2;
+#endif
+typedef double    Vector __attribute__((vector_size(lanes*sizeof(double))));
+typedef long long Mask   __attribute__((vector_size(lanes*sizeof(long long))));
+
+inline Vector abs (Vector v) {
+    Mask magnitude;
+    for (size_t k = 0; k < lanes; ++k) {
+        magnitude[k] = 0x7fffffffffffffffLL;
+    }
+    return reinterpret_cast<Vector>(reinterpret_cast<Mask>(v) & magnitude);
+}
+
+inline Vector broadcast (double x) {
+    Vector v;
+    for (size_t k = 0; k < lanes; ++k) {
+        v[k] = x;
+    }
+    return v;
+}
+
+inline void load (Point2 const* p, Vector& x, Vector& y) {
+    for (size_t k = 0; k < lanes; ++k) {
+        x[k] = p[k].x();
+        y[k] = p[k].y();
+    }
+}
+
+inline void store (Vector const& x, Vector const& y, Point2* p) {
+    for (size_t k = 0; k < lanes; ++k) {
+        p[k] = Point2(x[k], y[k]);
+    }
+}
+#endif
+
+} // namespace
+
+void Exact_adaptive_kernel::oriented_sides (Point2 const& pa, Point2 const& pb, Point2 const* tests, size_t n, Oriented_side* results)
+{
+    size_t i = 0;
+#if defined(__GNUC__)
+    Vector ax = broadcast(pa.x()), ay = broadcast(pa.y());
+    Vector bx = broadcast(pb.x()), by = broadcast(pb.y());
+    Vector bound = broadcast(predicates::ccwerrboundA);
+    for (; i + lanes <= n; i += lanes) {
+        Vector tx, ty;
+        load(tests + i, tx, ty);
+        Vector detleft = (ax - tx)*(by - ty);
+        Vector detright = (ay - ty)*(bx - tx);
+        Vector det = detleft - detright;
+        Vector detsum = abs(detleft) + abs(detright);
+        Mask certain = abs(det) >= bound*detsum;
+        for (size_t k = 0; k < lanes; ++k) {
+            double d = det[k];
+            if (certain[k]) {
+                UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_A);
+            } else {
+                d = orient2dadapt(pa.coord(), pb.coord(), tests[i+k].coord(), detsum[k]);
+            }
+            results[i+k] = sign(d);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        results[i] = oriented_side(pa, pb, tests[i]);
+    }
+}
+
+void Exact_adaptive_kernel::oriented_circles (Point2 const* pa, Point2 const* pb, Point2 const* pc, Point2 const* tests, size_t n, Oriented_side* results)
 {
-    double r = orient2d(pa.coord(), pb.coord(), test.coord());
-    if (r > 0.0)
-        return ON_POSITIVE_SIDE;
-    else if (r < 0.0)
-        return ON_NEGATIVE_SIDE;
-    else
-        return ON_ORIENTED_BOUNDARY;
+    size_t i = 0;
+#if defined(__GNUC__)
+    Vector bound = broadcast(predicates::iccerrboundA);
+    for (; i + lanes <= n; i += lanes) {
+        Vector ax, ay, bx, by, cx, cy, tx, ty;
+        load(pa + i, ax, ay);
+        load(pb + i, bx, by);
+        load(pc + i, cx, cy);
+        load(tests + i, tx, ty);
+        Vector adx = ax - tx, ady = ay - ty;
+        Vector bdx = bx - tx, bdy = by - ty;
+        Vector cdx = cx - tx, cdy = cy - ty;
+        Vector bdxcdy = bdx*cdy, cdxbdy = cdx*bdy;
+        Vector cdxady = cdx*ady, adxcdy = adx*cdy;
+        Vector adxbdy = adx*bdy, bdxady = bdx*ady;
+        Vector alift = adx*adx + ady*ady;
+        Vector blift = bdx*bdx + bdy*bdy;
+        Vector clift = cdx*cdx + cdy*cdy;
+        Vector det = alift*(bdxcdy - cdxbdy) + blift*(cdxady - adxcdy) + clift*(adxbdy - bdxady);
+        Vector permanent = (abs(bdxcdy) + abs(cdxbdy))*alift
+                         + (abs(cdxady) + abs(adxcdy))*blift
+                         + (abs(adxbdy) + abs(bdxady))*clift;
+        Mask certain = abs(det) > bound*permanent;
+        for (size_t k = 0; k < lanes; ++k) {
+            double d = det[k];
+            if (certain[k]) {
+                UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_A);
+            } else {
+                d = incircleadapt(pa[i+k].coord(), pb[i+k].coord(), pc[i+k].coord(), tests[i+k].coord(), permanent[k]);
+            }
+            results[i+k] = sign(d);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        results[i] = oriented_circle(pa[i], pb[i], pc[i], tests[i]);
+    }
 }
 
-Exact_adaptive_kernel::Oriented_side Exact_adaptive_kernel::oriented_circle (Point2 const& pa, Point2 const& pb, Point2 const& pc, Point2 const& test)
+void Exact_adaptive_kernel::distances (Point2 const* p1, Point2 const* p2, size_t n, double* results)
 {
-    double r = incircle(pa.coord(), pb.coord(), pc.coord(), test.coord());
-    if (r > 0.0)
-        return ON_POSITIVE_SIDE;
-    else if (r < 0.0)
-        return ON_NEGATIVE_SIDE;
-    else
-        return ON_ORIENTED_BOUNDARY;    
+    size_t i = 0;
+#if defined(__GNUC__)
+    for (; i + lanes <= n; i += lanes) {
+        Vector x1, y1, x2, y2;
+        load(p1 + i, x1, y1);
+        load(p2 + i, x2, y2);
+        Vector dx = x1 - x2, dy = y1 - y2;
+        Vector d2 = dx*dx + dy*dy;
+        for (size_t k = 0; k < lanes; ++k) {
+            results[i+k] = std::sqrt(d2[k]);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        results[i] = distance(p1[i], p2[i]);
+    }
+}
+
+void Exact_adaptive_kernel::circumcenters (Point2 const* p1, Point2 const* p2, Point2 const* p3, size_t n, Point2* results)
+{
+    size_t i = 0;
+#if defined(__GNUC__)
+    for (; i + lanes <= n; i += lanes) {
+        Vector x1, y1, x2, y2, x3, y3;
+        load(p1 + i, x1, y1);
+        load(p2 + i, x2, y2);
+        load(p3 + i, x3, y3);
+        Vector bx = x2 - x1, by = y2 - y1;
+        Vector cx = x3 - x1, cy = y3 - y1;
+        Vector b2 = bx*bx + by*by;
+        Vector c2 = cx*cx + cy*cy;
+        Vector denominator = broadcast(0.5)/(bx*cy - by*cx);
+        store(x1 + (cy*b2 - by*c2)*denominator, y1 + (bx*c2 - cx*b2)*denominator, results + i);
+    }
+#endif
+    for (; i < n; ++i) {
+        double bx = p2[i].x() - p1[i].x(), by = p2[i].y() - p1[i].y();
+        double cx = p3[i].x() - p1[i].x(), cy = p3[i].y() - p1[i].y();
+        double b2 = bx*bx + by*by;
+        double c2 = cx*cx + cy*cy;
+        double denominator = 0.5/(bx*cy - by*cx);
+        results[i] = Point2(p1[i].x() + (cy*b2 - by*c2)*denominator, p1[i].y() + (bx*c2 - cx*b2)*denominator);
+    }
+}
+
+// The squared lengths and the areas are evaluated in vector registers, the
+// sines by min_angle_sine_squared like in the faces.
+void Exact_adaptive_kernel::minimum_angles (Point2 const* p1, Point2 const* p2, Point2 const* p3, size_t n, double* results)
+{
+    size_t i = 0;
+#if defined(__GNUC__)
+    for (; i + lanes <= n; i += lanes) {
+        Vector x1, y1, x2, y2, x3, y3;
+        load(p1 + i, x1, y1);
+        load(p2 + i, x2, y2);
+        load(p3 + i, x3, y3);
+        Vector ax = x3 - x2, ay = y3 - y2;
+        Vector bx = x1 - x3, by = y1 - y3;
+        Vector cx = x2 - x1, cy = y2 - y1;
+        Vector a2 = ax*ax + ay*ay;
+        Vector b2 = bx*bx + by*by;
+        Vector c2 = cx*cx + cy*cy;
+        Vector twice_area = cx*(y3 - y1) - cy*(x3 - x1);
+        for (size_t k = 0; k < lanes; ++k) {
+            results[i+k] = std::asin(std::sqrt(min_angle_sine_squared(twice_area[k], a2[k], b2[k], c2[k])));
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        double a2 = distance_squared(p2[i], p3[i]);
+        double b2 = distance_squared(p3[i], p1[i]);
+        double c2 = distance_squared(p1[i], p2[i]);
+        double twice_area = (p2[i].x() - p1[i].x())*(p3[i].y() - p1[i].y()) - (p2[i].y() - p1[i].y())*(p3[i].x() - p1[i].x());
+        results[i] = std::asin(std::sqrt(min_angle_sine_squared(twice_area, a2, b2, c2)));
+    }
 }
 
 Point2 Exact_adaptive_kernel::circumcenter(Point2 const& p1, Point2 const& p2, Point2 const& p3)
@@ -91,8 +265,9 @@ Point2 Exact_adaptive_kernel::offcenter(Point2 const& p1, Point2 const& p2, Poin
             dy = dyoff;
         }
     } else {
-        dxoff = 0.5 * p2p3.x() - offconstant * p2p3.y();
-        dyoff = 0.5 * p2p3.y() + offconstant * p2p3.x();
+        // the off-center lies on the interior side of the edge p2 -> p3
+        dxoff = -0.5 * p2p3.x() + offconstant * p2p3.y();
+        dyoff = -0.5 * p2p3.y() - offconstant * p2p3.x();
         if (dxoff * dxoff + dyoff * dyoff < (dx - p2p1.x()) * (dx - p2p1.x()) + (dy - p2p1.y()) * (dy - p2p1.y())) {
             dx = p2p1.x() + dxoff;
             dy = p2p1.y() + dyoff;
@@ -23,11 +23,15 @@
 #define __EXACT_ADAPTIVE_KERNEL_H_INCLUDED__
 
 #include "Point2.h"
+#include "Predicate_statistics.h"
+#include "Predicates.h"
 
 #include <boost/assert.hpp>
 #include <boost/math/constants/constants.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 
 namespace umeshu {
 
@@ -37,8 +41,69 @@ class Exact_adaptive_kernel {
 
         typedef enum {ON_POSITIVE_SIDE, ON_NEGATIVE_SIDE, ON_ORIENTED_BOUNDARY} Oriented_side;
 
-        static Oriented_side oriented_side   (Point_2 const& pa, Point_2 const& pb, Point_2 const& test);
-        static Oriented_side oriented_circle (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc, Point_2 const& test);
+        // With inexact predicates, the algorithms check for the topological
+        // failures that inconsistent results can cause.
+        static const bool has_exact_predicates = true;
+
+        // The predicates first evaluate the determinants in floating point
+        // and accept the sign if it is certain by the error bounds of
+        // Shewchuk's predicates. Only otherwise they call the adaptive
+        // stages, so the fast path is inlined into the callers.
+        static Oriented_side oriented_side (Point_2 const& pa, Point_2 const& pb, Point_2 const& test) {
+            double detleft = (pa.x() - test.x())*(pb.y() - test.y());
+            double detright = (pa.y() - test.y())*(pb.x() - test.x());
+            double det = detleft - detright;
+            double detsum = std::abs(detleft) + std::abs(detright);
+            if (std::abs(det) < predicates::ccwerrboundA*detsum) {
+                det = orient2dadapt(pa.coord(), pb.coord(), test.coord(), detsum);
+            } else {
+                UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_A);
+            }
+            return sign(det);
+        }
+
+        static Oriented_side oriented_circle (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc, Point_2 const& test) {
+            double adx = pa.x() - test.x(), ady = pa.y() - test.y();
+            double bdx = pb.x() - test.x(), bdy = pb.y() - test.y();
+            double cdx = pc.x() - test.x(), cdy = pc.y() - test.y();
+            double bdxcdy = bdx*cdy, cdxbdy = cdx*bdy;
+            double cdxady = cdx*ady, adxcdy = adx*cdy;
+            double adxbdy = adx*bdy, bdxady = bdx*ady;
+            double alift = adx*adx + ady*ady;
+            double blift = bdx*bdx + bdy*bdy;
+            double clift = cdx*cdx + cdy*cdy;
+            double det = alift*(bdxcdy - cdxbdy) + blift*(cdxady - adxcdy) + clift*(adxbdy - bdxady);
+            double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy))*alift
+                             + (std::abs(cdxady) + std::abs(adxcdy))*blift
+                             + (std::abs(adxbdy) + std::abs(bdxady))*clift;
+            if (std::abs(det) <= predicates::iccerrboundA*permanent) {
+                det = incircleadapt(pa.coord(), pb.coord(), pc.coord(), test.coord(), permanent);
+            } else {
+                UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_A);
+            }
+            return sign(det);
+        }
+
+        // Batched predicates that evaluate the floating-point filter for
+        // several inputs at once in vector registers and call the adaptive
+        // stages only for the inputs whose sign is uncertain. The results
+        // are those of oriented_side(pa, pb, tests[i]) and of
+        // oriented_circle(pa[i], pb[i], pc[i], tests[i]), i = 0,...,n-1.
+        // They pay off only when every result is needed; the ear test of
+        // the triangulator stops at the first point inside and stays scalar.
+        static void oriented_sides   (Point_2 const& pa, Point_2 const& pb, Point_2 const* tests, size_t n, Oriented_side* results);
+        static void oriented_circles (Point_2 const* pa, Point_2 const* pb, Point_2 const* pc, Point_2 const* tests, size_t n, Oriented_side* results);
+
+        // Counts of the predicate evaluations by stage; see
+        // Predicate_statistics.
+        static Predicate_statistics statistics () {
+            return Predicate_statistics::current();
+        }
+
+        static void reset_statistics () {
+            Predicate_statistics::reset();
+        }
+
         static Point_2 circumcenter (Point_2 const& p1, Point_2 const& p2, Point_2 const& p3);
         static Point_2 offcenter    (Point_2 const& p1, Point_2 const& p2, Point_2 const& p3, double offconstant);
         static double  signed_area  (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc);
@@ -53,6 +118,20 @@ class Exact_adaptive_kernel {
             return std::sqrt(distance_squared(p1, p2));
         }
 
+        // Batched constructions for passes over whole meshes, evaluated in
+        // vector registers like the batched predicates. The circumcenters
+        // are computed in floating point, without the exact orientation
+        // used by circumcenter(). The angles are in radians.
+        static void distances      (Point_2 const* p1, Point_2 const* p2, size_t n, double* results);
+        static void circumcenters  (Point_2 const* p1, Point_2 const* p2, Point_2 const* p3, size_t n, Point_2* results);
+        static void minimum_angles (Point_2 const* p1, Point_2 const* p2, Point_2 const* p3, size_t n, double* results);
+
+        // Kernels that restrict the points to a grid round constructed
+        // points to it; here every point is representable.
+        static Point_2 snap (Point_2 const& p) {
+            return p;
+        }
+
         static Point_2 midpoint (Point_2 const& p1, Point_2 const& p2) {
             return Point_2(0.5*(p1.x()+p2.x()), 0.5*(p1.y()+p2.y()));
         }
@@ -65,6 +144,14 @@ class Exact_adaptive_kernel {
             return 0.25*a*b*c/(std::sqrt(s*(s-a)*(s-b)*(s-c)));
         }
 
+        // Squared sine of the smallest angle of a triangle, given twice its
+        // signed area and the squared lengths of its sides. The smallest
+        // angle lies opposite to the shortest side and its sine is twice
+        // the area divided by the lengths of the two other sides.
+        static double min_angle_sine_squared (double twice_area, double a2, double b2, double c2) {
+            return twice_area*twice_area*std::min(a2, std::min(b2, c2))/(a2*b2*c2);
+        }
+
         static void triangle_angles (Point_2 const& p1, Point_2 const& p2, Point_2 const& p3, double& a1, double& a2, double& a3) {
             double a, b, c;
             a = distance(p2, p3);
@@ -83,6 +170,37 @@ class Exact_adaptive_kernel {
             const double one_third = boost::math::constants::third<double>();
             return Point2(one_third*(p1.x()+p2.x()+p3.x()),one_third*(p1.y()+p2.y()+p3.y()));
         }
+
+    protected:
+        static Oriented_side sign (double det) {
+            if (det > 0.0)
+                return ON_POSITIVE_SIDE;
+            else if (det < 0.0)
+                return ON_NEGATIVE_SIDE;
+            else
+                return ON_ORIENTED_BOUNDARY;
+        }
+
+};
+
+// Batched predicates of kernels without a vectorised filter, which
+// evaluate the predicates of Kernel one by one.
+template <typename Kernel>
+struct Scalar_batched_predicates {
+    typedef typename Kernel::Point_2       Point_2;
+    typedef typename Kernel::Oriented_side Oriented_side;
+
+    static void oriented_sides (Point_2 const& pa, Point_2 const& pb, Point_2 const* tests, size_t n, Oriented_side* results) {
+        for (size_t i = 0; i < n; ++i) {
+            results[i] = Kernel::oriented_side(pa, pb, tests[i]);
+        }
+    }
+
+    static void oriented_circles (Point_2 const* pa, Point_2 const* pb, Point_2 const* pc, Point_2 const* tests, size_t n, Oriented_side* results) {
+        for (size_t i = 0; i < n; ++i) {
+            results[i] = Kernel::oriented_circle(pa[i], pb[i], pc[i], tests[i]);
+        }
+    }
 };
 
 } // namespace umeshu
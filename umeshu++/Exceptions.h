@@ -8,6 +8,10 @@ namespace umeshu {
 
 struct umeshu_error : virtual std::exception, virtual boost::exception { };
 
+// thrown when inconsistent predicates of an inexact kernel have left the
+// mesh in a state that the algorithms cannot continue from
+struct topology_error : virtual umeshu_error { };
+
 } // namespace umeshu
 
 #endif /* __EXCEPTIONS_H_INCLUDED__ */
@@ -0,0 +1,69 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __FAST_KERNEL_H_INCLUDED__
+#define __FAST_KERNEL_H_INCLUDED__
+
+#include "Exact_adaptive_kernel.h"
+
+namespace umeshu {
+
+// Kernel for quick previews whose predicates are the plain floating-point
+// determinants. They can be wrong for nearly degenerate inputs, in which
+// case the triangulation and the meshers throw topology_error rather than
+// corrupting the mesh or looping forever. Since the filters of the exact
+// kernel almost always decide, refinements are faster only for large
+// meshes in optimized builds; see umeshu-kernel-benchmark.
+class Fast_kernel : public Exact_adaptive_kernel {
+    public:
+        static const bool has_exact_predicates = false;
+
+        static Oriented_side oriented_side (Point_2 const& pa, Point_2 const& pb, Point_2 const& test) {
+            return sign((pa.x() - test.x())*(pb.y() - test.y()) - (pa.y() - test.y())*(pb.x() - test.x()));
+        }
+
+        static Oriented_side oriented_circle (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc, Point_2 const& test) {
+            double adx = pa.x() - test.x(), ady = pa.y() - test.y();
+            double bdx = pb.x() - test.x(), bdy = pb.y() - test.y();
+            double cdx = pc.x() - test.x(), cdy = pc.y() - test.y();
+            double alift = adx*adx + ady*ady;
+            double blift = bdx*bdx + bdy*bdy;
+            double clift = cdx*cdx + cdy*cdy;
+            return sign(alift*(bdx*cdy - cdx*bdy) + blift*(cdx*ady - adx*cdy) + clift*(adx*bdy - bdx*ady));
+        }
+
+        static void oriented_sides (Point_2 const& pa, Point_2 const& pb, Point_2 const* tests, size_t n, Oriented_side* results) {
+            Scalar_batched_predicates<Fast_kernel>::oriented_sides(pa, pb, tests, n, results);
+        }
+
+        static void oriented_circles (Point_2 const* pa, Point_2 const* pb, Point_2 const* pc, Point_2 const* tests, size_t n, Oriented_side* results) {
+            Scalar_batched_predicates<Fast_kernel>::oriented_circles(pa, pb, pc, tests, n, results);
+        }
+
+        static double signed_area (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc) {
+            return 0.5*((pa.x() - pc.x())*(pb.y() - pc.y()) - (pa.y() - pc.y())*(pb.x() - pc.x()));
+        }
+};
+
+} // namespace umeshu
+
+#endif /* __FAST_KERNEL_H_INCLUDED__ */
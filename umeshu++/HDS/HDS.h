@@ -22,9 +22,19 @@
 #ifndef __HDS_H_INCLUDED__
 #define __HDS_H_INCLUDED__ 
 
+#include <boost/assert.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/pool/object_pool.hpp>
 #include <list>
+#include <vector>
+
+#if defined(__GNUC__)
+#define UMESHU_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define UMESHU_THREAD_LOCAL __declspec(thread)
+#else
+#error "No thread-local storage for the staging areas of HDS"
+#endif
 
 namespace umeshu {
 namespace hds {
@@ -91,41 +101,135 @@ public:
     size_t number_of_edges () const { return edges_.size(); }
     size_t number_of_faces () const { return faces_.size(); }
 
+    void clear () {
+        faces_.clear();
+        edges_.clear();
+        halfedges_.clear();
+        nodes_.clear();
+    }
+
+    // Moves all elements of another structure to the end of this one. The
+    // handles of the moved elements stay valid.
+    void splice (HDS& other) {
+        nodes_.splice(nodes_.end(), other.nodes_);
+        halfedges_.splice(halfedges_.end(), other.halfedges_);
+        edges_.splice(edges_.end(), other.edges_);
+        faces_.splice(faces_.end(), other.faces_);
+    }
+
+    // Concurrent updates by threads that change disjoint parts of the
+    // structure, i.e., parts that share no node. Between
+    // begin_concurrent_updates and end_concurrent_updates, a thread that
+    // called use_staging_area allocates new elements in lists of its own
+    // and defers the deletions, so that the threads do not race on the
+    // shared lists. end_concurrent_updates then moves the new elements to
+    // the shared lists, which keeps their handles valid, and deletes the
+    // removed ones. The numbers of elements are updated only then.
+    void begin_concurrent_updates (size_t number_of_threads) {
+        if (staging_areas_.size() < number_of_threads) {
+            staging_areas_.resize(number_of_threads);
+        }
+    }
+
+    void use_staging_area (size_t thread) {
+        BOOST_ASSERT(thread < staging_areas_.size());
+        staging_area_ = &staging_areas_[thread];
+    }
+
+    void leave_staging_area () {
+        staging_area_ = NULL;
+    }
+
+    void end_concurrent_updates () {
+        BOOST_ASSERT(staging_area_ == NULL);
+        for (typename std::vector<Staging_area>::iterator iter = staging_areas_.begin(); iter != staging_areas_.end(); ++iter) {
+            nodes_.splice(nodes_.end(), iter->nodes);
+            halfedges_.splice(halfedges_.end(), iter->halfedges);
+            edges_.splice(edges_.end(), iter->edges);
+            faces_.splice(faces_.end(), iter->faces);
+            for (size_t i = 0; i < iter->deleted_nodes.size(); ++i) {
+                delete_node(iter->deleted_nodes[i]);
+            }
+            for (size_t i = 0; i < iter->deleted_edges.size(); ++i) {
+                delete_edge(iter->deleted_edges[i]);
+            }
+            for (size_t i = 0; i < iter->deleted_faces.size(); ++i) {
+                delete_face(iter->deleted_faces[i]);
+            }
+            iter->deleted_nodes.clear();
+            iter->deleted_edges.clear();
+            iter->deleted_faces.clear();
+        }
+    }
+
 protected:
     Node_handle get_new_node () {
-        return nodes_.insert(nodes_.end(), Node());
+        Node_list& nodes = staging_area_ != NULL ? staging_area_->nodes : nodes_;
+        return nodes.insert(nodes.end(), Node());
     }
     Edge_handle get_new_edge () {
-        Halfedge_handle he1 = halfedges_.insert(halfedges_.end(), Halfedge());
-        Halfedge_handle he2 = halfedges_.insert(halfedges_.end(), Halfedge());
-        Edge_handle e = edges_.insert(edges_.end(), Edge(he1, he2));
+        Halfedge_list& halfedges = staging_area_ != NULL ? staging_area_->halfedges : halfedges_;
+        Edge_list& edges = staging_area_ != NULL ? staging_area_->edges : edges_;
+        Halfedge_handle he1 = halfedges.insert(halfedges.end(), Halfedge());
+        Halfedge_handle he2 = halfedges.insert(halfedges.end(), Halfedge());
+        Edge_handle e = edges.insert(edges.end(), Edge(he1, he2));
         he1->set_edge(e);
         he2->set_edge(e);
         return e;
     }
     Face_handle get_new_face () {
-        return faces_.insert(faces_.end(), Face());
+        Face_list& faces = staging_area_ != NULL ? staging_area_->faces : faces_;
+        return faces.insert(faces.end(), Face());
     }
 
     void delete_node (Node_handle n) {
-        nodes_.erase(n);
+        if (staging_area_ != NULL) {
+            staging_area_->deleted_nodes.push_back(n);
+        } else {
+            nodes_.erase(n);
+        }
     }
     void delete_edge (Edge_handle e) {
-        halfedges_.erase(e->he1());
-        halfedges_.erase(e->he2());
-        edges_.erase(e);
+        if (staging_area_ != NULL) {
+            staging_area_->deleted_edges.push_back(e);
+        } else {
+            halfedges_.erase(e->he1());
+            halfedges_.erase(e->he2());
+            edges_.erase(e);
+        }
     }
     void delete_face (Face_handle f) {
-        faces_.erase(f);
+        if (staging_area_ != NULL) {
+            staging_area_->deleted_faces.push_back(f);
+        } else {
+            faces_.erase(f);
+        }
     }
 
 private:
+    struct Staging_area {
+        Node_list     nodes;
+        Halfedge_list halfedges;
+        Edge_list     edges;
+        Face_list     faces;
+        std::vector<Node_handle> deleted_nodes;
+        std::vector<Edge_handle> deleted_edges;
+        std::vector<Face_handle> deleted_faces;
+    };
+
     Node_list     nodes_;
     Halfedge_list halfedges_;
     Edge_list     edges_;
     Face_list     faces_;
+
+    std::vector<Staging_area> staging_areas_;
+    // the staging area used by the calling thread, if any
+    static UMESHU_THREAD_LOCAL Staging_area* staging_area_;
 };
 
+template <typename Items, typename Kernel, typename Alloc>
+UMESHU_THREAD_LOCAL typename HDS<Items, Kernel, Alloc>::Staging_area* HDS<Items, Kernel, Alloc>::staging_area_ = NULL;
+
 } // namespace hds
 } // namespace umeshu
 
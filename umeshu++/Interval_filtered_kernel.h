@@ -0,0 +1,133 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __INTERVAL_FILTERED_KERNEL_H_INCLUDED__
+#define __INTERVAL_FILTERED_KERNEL_H_INCLUDED__
+
+#include "Exact_adaptive_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace umeshu {
+
+// Closed interval of doubles that contains the exact result of the
+// operations that produced it. The operations round to nearest and then
+// widen the result outwards by more than the rounding error, so they do
+// not need to switch the rounding mode of the processor.
+class Interval {
+public:
+    explicit Interval (double x) : lo_(x), hi_(x) { }
+    Interval (double lo, double hi) : lo_(lo), hi_(hi) { }
+
+    double lo () const { return lo_; }
+    double hi () const { return hi_; }
+
+    bool is_positive () const { return lo_ > 0.0; }
+    bool is_negative () const { return hi_ < 0.0; }
+
+    friend Interval operator+ (Interval const& a, Interval const& b) {
+        return widened(a.lo_ + b.lo_, a.hi_ + b.hi_);
+    }
+
+    friend Interval operator- (Interval const& a, Interval const& b) {
+        return widened(a.lo_ - b.hi_, a.hi_ - b.lo_);
+    }
+
+    friend Interval operator* (Interval const& a, Interval const& b) {
+        double p1 = a.lo_*b.lo_, p2 = a.lo_*b.hi_, p3 = a.hi_*b.lo_, p4 = a.hi_*b.hi_;
+        return widened(std::min(std::min(p1, p2), std::min(p3, p4)),
+                       std::max(std::max(p1, p2), std::max(p3, p4)));
+    }
+
+    friend Interval square (Interval const& a) {
+        if (a.lo_ >= 0.0) {
+            return widened(a.lo_*a.lo_, a.hi_*a.hi_);
+        } else if (a.hi_ <= 0.0) {
+            return widened(a.hi_*a.hi_, a.lo_*a.lo_);
+        } else {
+            return widened(0.0, std::max(a.lo_*a.lo_, a.hi_*a.hi_));
+        }
+    }
+
+private:
+    // The relative rounding error of an operation is at most 2^-53, the
+    // absolute error of an underflowing product at most the smallest
+    // denormal. Widening by twice that also covers the rounding of the
+    // widening itself.
+    static Interval widened (double lo, double hi) {
+        double const eps = std::numeric_limits<double>::epsilon();
+        double const tiny = std::numeric_limits<double>::denorm_min();
+        return Interval(lo - (std::abs(lo)*eps + tiny), hi + (std::abs(hi)*eps + tiny));
+    }
+
+    double lo_, hi_;
+};
+
+// Kernel whose predicates evaluate the determinants in interval arithmetic
+// and fall back to the exact adaptive predicates only when the interval
+// contains zero. The constructions are those of Exact_adaptive_kernel.
+class Interval_filtered_kernel : public Exact_adaptive_kernel {
+    public:
+        static Oriented_side oriented_side (Point_2 const& pa, Point_2 const& pb, Point_2 const& test) {
+            Interval acx = Interval(pa.x()) - Interval(test.x());
+            Interval bcx = Interval(pb.x()) - Interval(test.x());
+            Interval acy = Interval(pa.y()) - Interval(test.y());
+            Interval bcy = Interval(pb.y()) - Interval(test.y());
+            Interval det = acx*bcy - acy*bcx;
+            if (det.is_positive()) {
+                return ON_POSITIVE_SIDE;
+            } else if (det.is_negative()) {
+                return ON_NEGATIVE_SIDE;
+            }
+            return sign(orient2d(pa.coord(), pb.coord(), test.coord()));
+        }
+
+        static Oriented_side oriented_circle (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc, Point_2 const& test) {
+            Interval adx = Interval(pa.x()) - Interval(test.x()), ady = Interval(pa.y()) - Interval(test.y());
+            Interval bdx = Interval(pb.x()) - Interval(test.x()), bdy = Interval(pb.y()) - Interval(test.y());
+            Interval cdx = Interval(pc.x()) - Interval(test.x()), cdy = Interval(pc.y()) - Interval(test.y());
+            Interval alift = square(adx) + square(ady);
+            Interval blift = square(bdx) + square(bdy);
+            Interval clift = square(cdx) + square(cdy);
+            Interval det = alift*(bdx*cdy - cdx*bdy) + blift*(cdx*ady - adx*cdy) + clift*(adx*bdy - bdx*ady);
+            if (det.is_positive()) {
+                return ON_POSITIVE_SIDE;
+            } else if (det.is_negative()) {
+                return ON_NEGATIVE_SIDE;
+            }
+            return sign(incircle(pa.coord(), pb.coord(), pc.coord(), test.coord()));
+        }
+
+        static void oriented_sides (Point_2 const& pa, Point_2 const& pb, Point_2 const* tests, size_t n, Oriented_side* results) {
+            Scalar_batched_predicates<Interval_filtered_kernel>::oriented_sides(pa, pb, tests, n, results);
+        }
+
+        static void oriented_circles (Point_2 const* pa, Point_2 const* pb, Point_2 const* pc, Point_2 const* tests, size_t n, Oriented_side* results) {
+            Scalar_batched_predicates<Interval_filtered_kernel>::oriented_circles(pa, pb, pc, tests, n, results);
+        }
+};
+
+} // namespace umeshu
+
+#endif /* __INTERVAL_FILTERED_KERNEL_H_INCLUDED__ */
@@ -0,0 +1,166 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __LOCAL_FEATURE_SIZE_H_INCLUDED__
+#define __LOCAL_FEATURE_SIZE_H_INCLUDED__ 
+
+#include "Background_grid.h"
+#include "Polygon.h"
+#include "Triangulator.h"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace umeshu {
+
+// Estimates the local feature size of a polygon, i.e., the distance from
+// a point to the nearest feature of the boundary that does not pass
+// through it, at the vertices of the polygon. The estimate at a vertex is
+// the shortest of the edges that leave the vertex in the constrained
+// Delaunay triangulation of the polygon and of the distances from the
+// vertex to the boundary edges opposite to it in its faces, which catches
+// both short boundary edges and narrow channels.
+template <typename Delaunay_triangulation>
+class Local_feature_size {
+public:
+    typedef          Delaunay_triangulation      Tria;
+    typedef typename Tria::Kernel                Kernel;
+    typedef typename Kernel::Point_2             Point_2;
+
+    typedef typename Tria::Node_iterator         Node_iterator;
+    typedef typename Tria::Halfedge_handle       Halfedge_handle;
+
+    explicit Local_feature_size (Polygon const& boundary)
+        : boundary_(boundary)
+    {
+        Tria tria;
+        Triangulator<Tria> triangulator;
+        triangulator.triangulate(boundary, tria);
+        tria.make_cdt();
+
+        // the triangulator adds the nodes in the order of the vertices,
+        // first of the outer boundary and then of the holes
+        Node_iterator node = tria.nodes_begin();
+        lfs_.resize(boundary_.number_of_holes() + 1);
+        for (size_t r = 0; r < lfs_.size(); ++r) {
+            Polygon::vertex_const_iterator vertex = ring(r).vertices_begin();
+            for (; vertex != ring(r).vertices_end(); ++vertex, ++node) {
+                BOOST_ASSERT(node->position() == *vertex);
+                lfs_[r].push_back(at_node(node->halfedge()));
+            }
+        }
+    }
+
+    // estimate at the i-th vertex of the outer boundary
+    double at_vertex (size_t i) const { return lfs_[0][i]; }
+
+    // estimate at the i-th vertex of the hole-th hole
+    double at_hole_vertex (size_t hole, size_t i) const { return lfs_[hole+1][i]; }
+
+    // Background grid over the bounding box of the polygon with resolution
+    // cells along its longer side. The edge lengths are the local feature
+    // size divided by elements_per_feature and grow by at most grading per
+    // unit distance away from the boundary.
+    Background_grid sizing_grid (double elements_per_feature, double grading, int resolution = 128) const {
+        Bounding_box bb = boundary_.bounding_box();
+        double cell = std::max(bb.width(), bb.height())/resolution;
+        int nx = std::max(2, static_cast<int>(std::ceil(bb.width()/cell)) + 1);
+        int ny = std::max(2, static_cast<int>(std::ceil(bb.height()/cell)) + 1);
+        Background_grid grid(bb, nx, ny, area(std::sqrt(bb.width()*bb.width() + bb.height()*bb.height())));
+        double dx = bb.width()/(nx - 1);
+        double dy = bb.height()/(ny - 1);
+
+        // every grid node around a sample of the boundary takes at most the
+        // size at the sample increased by the grading
+        for (size_t r = 0; r < lfs_.size(); ++r) {
+            size_t n = lfs_[r].size();
+            for (size_t i = 0; i < n; ++i) {
+                Point_2 const& p1 = ring(r).vertices_begin()[i];
+                Point_2 const& p2 = ring(r).vertices_begin()[(i+1) % n];
+                double h1 = lfs_[r][i]/elements_per_feature;
+                double h2 = lfs_[r][(i+1) % n]/elements_per_feature;
+                int samples = static_cast<int>(std::ceil(2.0*Kernel::distance(p1, p2)/std::min(dx, dy))) + 1;
+                for (int k = 0; k <= samples; ++k) {
+                    double t = static_cast<double>(k)/samples;
+                    Point_2 s(p1.x() + t*(p2.x() - p1.x()), p1.y() + t*(p2.y() - p1.y()));
+                    double h = (1.0 - t)*h1 + t*h2;
+                    int i0 = std::min(nx - 2, static_cast<int>((s.x() - bb.ll().x())/dx));
+                    int j0 = std::min(ny - 2, static_cast<int>((s.y() - bb.ll().y())/dy));
+                    for (int j = j0; j <= j0 + 1; ++j) {
+                        for (int i = i0; i <= i0 + 1; ++i) {
+                            double a = area(h + grading*Kernel::distance(s, grid.node(i, j)));
+                            grid.value(i, j) = std::min(grid.value(i, j), a);
+                        }
+                    }
+                }
+            }
+        }
+        grid.limit_gradient(grading);
+        return grid;
+    }
+
+private:
+    // area of the equilateral triangle with sides of length h
+    static double area (double h) {
+        return std::sqrt(3.0)/4.0*h*h;
+    }
+
+    // the outer boundary for r == 0, otherwise the (r-1)-th hole
+    Polygon const& ring (size_t r) const {
+        return r == 0 ? boundary_ : boundary_.holes_begin()[r-1];
+    }
+
+    static double at_node (Halfedge_handle he_start) {
+        double lfs = he_start->edge()->length();
+        Halfedge_handle he_iter = he_start;
+        do {
+            lfs = std::min(lfs, he_iter->edge()->length());
+            if (not he_iter->is_boundary()) {
+                Halfedge_handle opposite = he_iter->next();
+                if (opposite->edge()->is_boundary()) {
+                    lfs = std::min(lfs, distance_to_edge(he_iter->origin()->position(), opposite));
+                }
+            }
+            he_iter = he_iter->pair()->next();
+        } while (he_iter != he_start);
+        return lfs;
+    }
+
+    static double distance_to_edge (Point_2 const& p, Halfedge_handle he) {
+        Point_2 p1, p2;
+        he->vertices(p1, p2);
+        double ex = p2.x() - p1.x(), ey = p2.y() - p1.y();
+        double t = ((p.x() - p1.x())*ex + (p.y() - p1.y())*ey)/(ex*ex + ey*ey);
+        t = std::max(0.0, std::min(1.0, t));
+        return Kernel::distance(p, Point_2(p1.x() + t*ex, p1.y() + t*ey));
+    }
+
+    Polygon                            boundary_;
+    std::vector<std::vector<double> >  lfs_;
+};
+
+} // namespace umeshu
+
+#endif /* __LOCAL_FEATURE_SIZE_H_INCLUDED__ */
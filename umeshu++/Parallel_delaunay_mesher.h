@@ -0,0 +1,335 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __PARALLEL_DELAUNAY_MESHER_H_INCLUDED__
+#define __PARALLEL_DELAUNAY_MESHER_H_INCLUDED__ 
+
+#include "Delaunay_mesher.h"
+#include "Thread_pool.h"
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/unordered/unordered_set.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace umeshu {
+
+// Refines a mesh in rounds on a pool of threads that lives as long as the
+// mesher. In every round, a batch of the worst faces is taken from the
+// queue and the threads locate the Steiner points of the faces and compute
+// their cavities concurrently, without modifying the mesh. Insertions whose
+// cavities share no node with the cavity of an earlier insertion of the
+// round are then committed concurrently: the threads replace the cavities
+// and allocate the new elements in staging areas of the half-edge data
+// structure (see HDS::begin_concurrent_updates). Only merging the new
+// elements and updating the queue of bad faces is serial. The remaining
+// insertions, which split encroached boundary edges, are contended or
+// failed, are performed one by one afterwards unless an earlier commit
+// touched a face adjacent to their cavities, in which case their bad faces
+// are retried in the next round.
+template <typename Delaunay_triangulation, typename Quality = Delaunay_mesh_area_quality<Delaunay_triangulation> >
+class Parallel_delaunay_mesher : public Delaunay_mesher<Delaunay_triangulation, Quality> {
+public:
+    typedef          Delaunay_mesher<Delaunay_triangulation, Quality> Base;
+    typedef          Delaunay_triangulation      Tria;
+    typedef typename Tria::Kernel                Kernel;
+    typedef typename Kernel::Point_2             Point_2;
+
+    typedef typename Tria::Node                  Node;
+    typedef typename Tria::Face                  Face;
+
+    typedef typename Tria::Node_handle           Node_handle;
+    typedef typename Tria::Halfedge_handle       Halfedge_handle;
+    typedef typename Tria::Edge_handle           Edge_handle;
+    typedef typename Tria::Face_handle           Face_handle;
+
+    typedef typename Base::Bad_faces             Bad_faces;
+    typedef typename Base::Faces                 Faces;
+    typedef typename Base::Halfedges             Halfedges;
+
+    explicit Parallel_delaunay_mesher (unsigned number_of_threads = 0)
+        : number_of_threads_(number_of_threads)
+        , faces_per_thread_(64)
+    {
+        if (number_of_threads_ == 0) {
+            number_of_threads_ = std::max(1u, boost::thread::hardware_concurrency());
+        }
+    }
+
+    unsigned number_of_threads () const { return number_of_threads_; }
+
+    // number of bad faces that each thread processes in one round
+    void set_faces_per_thread (unsigned n) { faces_per_thread_ = std::max(1u, n); }
+
+    // number of insertions committed concurrently by the last call to refine
+    size_t concurrent_insertions () const { return concurrent_insertions_; }
+
+    void refine (Delaunay_triangulation& mesh, double max_area, double min_angle) {
+        this->initialize(mesh, max_area, min_angle);
+        if (pool_.get() == NULL) {
+            pool_.reset(new Thread_pool(number_of_threads_));
+        }
+        concurrent_insertions_ = 0;
+        this->touched_faces_ = &touched_in_round_;
+        while (not this->is_refined()) {
+            select_candidates();
+            pool_->run(boost::bind(&Parallel_delaunay_mesher::prepare_candidates, this, _1));
+            select_concurrent_insertions();
+            commit_concurrent_insertions();
+            commit_remaining_insertions();
+        }
+        this->finalize();
+        this->touched_faces_ = NULL;
+    }
+
+    void refine_to_node_budget (Delaunay_triangulation& mesh, size_t number_of_nodes, double min_angle) {
+        BOOST_ASSERT(number_of_nodes > 0);
+        size_t node_budget = this->node_budget();
+        this->set_node_budget(number_of_nodes);
+        refine(mesh, 0.0, min_angle);
+        this->set_node_budget(node_budget);
+    }
+
+private:
+    typedef typename Base::Insertion Insertion;
+
+    struct Candidate {
+        Insertion                insertion;
+        // faces whose change invalidates the insertion
+        std::vector<Face const*> lock_set;
+        // nodes of the cavity, which a concurrent insertion must not share
+        std::vector<Node const*> cavity_nodes;
+        bool                     concurrent;
+        // results of a concurrent commit, merged serially
+        std::vector<Quality>     removed_bad_faces, new_bad_faces;
+        Halfedges                encroached_edges;
+        double                   insertion_seconds;
+    };
+
+    void select_candidates () {
+        size_t n = std::min<size_t>(number_of_threads_*faces_per_thread_, this->bad_faces_.size());
+        candidates_.resize(std::max(candidates_.size(), n));
+        number_of_candidates_ = n;
+        typename Bad_faces::iterator iter = this->bad_faces_.begin();
+        for (size_t i = 0; i < n; ++i, ++iter) {
+            candidates_[i].insertion.bad_face = iter->face();
+        }
+    }
+
+    void prepare_candidates (unsigned thread) {
+        for (size_t i = thread; i < number_of_candidates_; i += number_of_threads_) {
+            Candidate& c = candidates_[i];
+            this->prepare_insertion(c.insertion);
+            collect_lock_set(c);
+        }
+    }
+
+    void collect_lock_set (Candidate& c) const {
+        Insertion const& ins = c.insertion;
+        c.lock_set.clear();
+        c.cavity_nodes.clear();
+        c.lock_set.push_back(&*ins.bad_face);
+        if (ins.topology_failed) {
+            return;
+        }
+        if (ins.loc == OUTSIDE_MESH) {
+            // the edge beyond which the point lies is split
+            if (not ins.edge->he1()->is_boundary()) {
+                c.lock_set.push_back(&*ins.edge->he1()->face());
+            }
+            if (not ins.edge->he2()->is_boundary()) {
+                c.lock_set.push_back(&*ins.edge->he2()->face());
+            }
+            return;
+        }
+        for (typename Faces::const_iterator iter = ins.cavity.faces.begin(); iter != ins.cavity.faces.end(); ++iter) {
+            c.lock_set.push_back(&**iter);
+            Halfedge_handle he = (*iter)->halfedge();
+            for (int i = 0; i < 3; ++i, he = he->next()) {
+                c.cavity_nodes.push_back(&*he->origin());
+            }
+        }
+        for (typename Halfedges::const_iterator iter = ins.cavity.boundary.begin(); iter != ins.cavity.boundary.end(); ++iter) {
+            Face_handle f = (*iter)->pair()->face();
+            if (f != Face_handle()) {
+                c.lock_set.push_back(&*f);
+            }
+        }
+    }
+
+    // An insertion that only replaces its cavity by a fan of new faces
+    bool is_plain_insertion (Insertion const& ins) const {
+        return not ins.topology_failed &&
+               (ins.loc == IN_FACE || (ins.loc == ON_EDGE && not this->is_fixed(ins.edge))) &&
+               ins.encroached.empty();
+    }
+
+    // Greedily selects the plain insertions in queue order whose cavities
+    // share no node with those selected before. Two such cavities share no
+    // face, edge or node ring, so they can be replaced concurrently. The
+    // node budget bounds the number of selected insertions.
+    void select_concurrent_insertions () {
+        claimed_nodes_.clear();
+        size_t available = std::numeric_limits<size_t>::max();
+        if (this->node_budget_ != 0) {
+            size_t n = this->mesh_->number_of_nodes();
+            available = n < this->node_budget_ ? this->node_budget_ - n : 0;
+        }
+        concurrent_.clear();
+        for (size_t i = 0; i < number_of_candidates_; ++i) {
+            Candidate& c = candidates_[i];
+            c.concurrent = false;
+            if (concurrent_.size() == available || not is_plain_insertion(c.insertion)) {
+                continue;
+            }
+            bool shared = false;
+            for (size_t k = 0; k < c.cavity_nodes.size() && not shared; ++k) {
+                shared = claimed_nodes_.find(c.cavity_nodes[k]) != claimed_nodes_.end();
+            }
+            if (not shared) {
+                claimed_nodes_.insert(c.cavity_nodes.begin(), c.cavity_nodes.end());
+                c.concurrent = true;
+                concurrent_.push_back(i);
+            }
+        }
+    }
+
+    void commit_concurrent_insertions () {
+        touched_in_round_.clear();
+        if (concurrent_.empty()) {
+            return;
+        }
+        BOOST_ASSERT(this->node_targets_.empty());
+        this->mesh_->begin_concurrent_updates(number_of_threads_);
+        pool_->run(boost::bind(&Parallel_delaunay_mesher::commit_concurrently, this, _1));
+
+        // The removed faces are still allocated until the updates end and
+        // can thus be looked up in the queue.
+        for (size_t k = 0; k < concurrent_.size(); ++k) {
+            Candidate& c = candidates_[concurrent_[k]];
+            for (typename std::vector<Quality>::const_iterator iter = c.removed_bad_faces.begin(); iter != c.removed_bad_faces.end(); ++iter) {
+                if (this->bad_faces_.erase(*iter) != 0) {
+                    ++this->statistics_.dequeued_faces;
+                }
+            }
+            touched_in_round_.insert(c.lock_set.begin(), c.lock_set.end());
+        }
+        this->mesh_->end_concurrent_updates();
+
+        for (size_t k = 0; k < concurrent_.size(); ++k) {
+            Candidate& c = candidates_[concurrent_[k]];
+            Insertion const& ins = c.insertion;
+            for (typename std::vector<Quality>::const_iterator iter = c.new_bad_faces.begin(); iter != c.new_bad_faces.end(); ++iter) {
+                if (this->bad_faces_.insert(*iter).second) {
+                    ++this->statistics_.enqueued_faces;
+                }
+            }
+            this->enc_hedges_.insert(c.encroached_edges.begin(), c.encroached_edges.end());
+            this->statistics_.locate_steps += ins.locate_steps;
+            this->statistics_.incircle_tests += ins.cavity.incircle_tests;
+            this->statistics_.locate_seconds += ins.locate_seconds;
+            this->statistics_.cavity_seconds += ins.cavity_seconds;
+            this->statistics_.insertion_seconds += c.insertion_seconds;
+            ++this->statistics_.steiner_points;
+            if (++this->steps_since_progress_ == this->progress_interval_) {
+                this->check_progress();
+            }
+        }
+        concurrent_insertions_ += concurrent_.size();
+    }
+
+    // Replaces the cavities of the concurrent insertions assigned to the
+    // thread and records the changes of the queue of bad faces as in
+    // insert_in_cavity and treat_new_node.
+    void commit_concurrently (unsigned thread) {
+        this->mesh_->use_staging_area(thread);
+        for (size_t k = thread; k < concurrent_.size(); k += number_of_threads_) {
+            Candidate& c = candidates_[concurrent_[k]];
+            Insertion const& ins = c.insertion;
+            boost::posix_time::ptime t0 = this->now();
+            c.removed_bad_faces.clear();
+            c.new_bad_faces.clear();
+            c.encroached_edges.clear();
+            for (typename Faces::const_iterator iter = ins.cavity.faces.begin(); iter != ins.cavity.faces.end(); ++iter) {
+                Quality q(*iter);
+                if (this->is_bad(q)) {
+                    c.removed_bad_faces.push_back(q);
+                }
+            }
+            Node_handle n = this->replace_cavity(ins.cavity, ins.point);
+            Halfedge_handle he_start = n->halfedge();
+            Halfedge_handle he_iter = he_start;
+            do {
+                Face_handle f = he_iter->face();
+                if (f != Face_handle()) {
+                    Edge_handle e = he_iter->next()->edge();
+                    if (e->is_constrained() && e->is_encroached_upon(n->position())) {
+                        c.encroached_edges.push_back(he_iter->next());
+                    } else {
+                        Quality q(f);
+                        if (this->is_bad(q)) {
+                            c.new_bad_faces.push_back(q);
+                        }
+                    }
+                }
+                he_iter = he_iter->pair()->next();
+            } while (he_iter != he_start);
+            c.insertion_seconds = this->seconds_between(t0, this->now());
+        }
+        this->mesh_->leave_staging_area();
+    }
+
+    bool is_contended (Candidate const& c) const {
+        for (typename std::vector<Face const*>::const_iterator iter = c.lock_set.begin(); iter != c.lock_set.end(); ++iter) {
+            if (touched_in_round_.find(*iter) != touched_in_round_.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void commit_remaining_insertions () {
+        for (size_t i = 0; i < number_of_candidates_ && not this->is_refined(); ++i) {
+            Candidate& c = candidates_[i];
+            if (not c.concurrent && not is_contended(c)) {
+                this->perform_insertion(c.insertion);
+            }
+        }
+    }
+
+    unsigned                         number_of_threads_;
+    unsigned                         faces_per_thread_;
+    boost::shared_ptr<Thread_pool>   pool_;
+    std::vector<Candidate>           candidates_;
+    size_t                           number_of_candidates_;
+    std::vector<size_t>              concurrent_;
+    boost::unordered_set<Node const*> claimed_nodes_;
+    typename Base::Touched_faces     touched_in_round_;
+    size_t                           concurrent_insertions_;
+};
+
+} // namespace umeshu
+
+#endif /* __PARALLEL_DELAUNAY_MESHER_H_INCLUDED__ */
@@ -24,6 +24,7 @@
 
 #include <boost/operators.hpp>
 
+#include <limits>
 #include <ostream>
 
 namespace umeshu {
@@ -45,16 +46,21 @@ public:
     
     double const* coord() const { return &coord_[0]; }
 
-    Point2 operator+=(Point2 const& p) { x() += p.x(); y() += p.y(); return *this; }
-    Point2 operator-=(Point2 const& p) { x() -= p.x(); y() -= p.y(); return *this; }
-    Point2 operator*=(double a) { x() *= a; y() *= a; return *this; }
-    Point2 operator/=(double a) { x() /= a; y() /= a; return *this; }
+    Point2& operator+=(Point2 const& p) { x() += p.x(); y() += p.y(); return *this; }
+    Point2& operator-=(Point2 const& p) { x() -= p.x(); y() -= p.y(); return *this; }
+    Point2& operator*=(double a) { x() *= a; y() *= a; return *this; }
+    Point2& operator/=(double a) { x() /= a; y() /= a; return *this; }
 
     friend bool          operator== (Point2 const& p1, Point2 const& p2);
     friend std::ostream& operator<< (std::ostream& os, Point2 const& p);
 
 private:
+    // aligned so that a point loads into one SSE register
+#if defined(__GNUC__)
+    double coord_[2] __attribute__((aligned(16)));
+#else
     double coord_[2];
+#endif
 };
 
 inline bool operator== (Point2 const& p1, Point2 const& p2)
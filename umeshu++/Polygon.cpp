@@ -32,6 +32,24 @@ Bounding_box Polygon::bounding_box() const
     return bb;
 }
 
+double Polygon::signed_area() const
+{
+    // relative to the first vertex, so that the products do not cancel
+    // for polygons far from the origin
+    double area = 0.0;
+    size_t n = vertices_.size();
+    if (n == 0) {
+        return area;
+    }
+    Point2 const& o = vertices_[0];
+    for (size_t i = 1; i + 1 < n; ++i) {
+        Point2 const& p1 = vertices_[i];
+        Point2 const& p2 = vertices_[i+1];
+        area += (p1.x() - o.x())*(p2.y() - o.y()) - (p2.x() - o.x())*(p1.y() - o.y());
+    }
+    return 0.5*area;
+}
+
 Polygon Polygon::triangle()
 {
     Polygon poly;
@@ -178,6 +196,37 @@ Polygon Polygon::letter_a()
     return poly;
 }
 
+Polygon Polygon::plate_with_holes()
+{
+    Polygon poly;
+    poly.append_vertex(Point2(0.0,0.0));
+    poly.append_vertex(Point2(1.013,0.021));
+    poly.append_vertex(Point2(0.987,1.004));
+    poly.append_vertex(Point2(0.012,0.991));
+
+    Polygon hole;
+    hole.append_vertex(Point2(0.15,0.2));
+    hole.append_vertex(Point2(0.45,0.15));
+    hole.append_vertex(Point2(0.4,0.45));
+    hole.append_vertex(Point2(0.2,0.4));
+    poly.add_hole(hole);
+
+    hole = Polygon();
+    hole.append_vertex(Point2(0.7,0.55));
+    hole.append_vertex(Point2(0.75,0.85));
+    hole.append_vertex(Point2(0.55,0.8));
+    hole.append_vertex(Point2(0.62,0.7));
+    poly.add_hole(hole);
+
+    hole = Polygon();
+    hole.append_vertex(Point2(0.65,0.15));
+    hole.append_vertex(Point2(0.85,0.2));
+    hole.append_vertex(Point2(0.8,0.35));
+    poly.add_hole(hole);
+
+    return poly;
+}
+
 Polygon Polygon::square(double size)
 {
     Polygon poly;
@@ -279,4 +328,59 @@ Polygon Polygon::crack()
     return poly;
 }
 
+// a wavy coast with a long thin pier reaching into the water
+Polygon Polygon::coastline()
+{
+    Polygon poly;
+
+    poly.append_vertex(Point2(0.0000, 0.0000));
+    poly.append_vertex(Point2(2.0000, 0.0000));
+    poly.append_vertex(Point2(2.0000, 1.0000));
+    poly.append_vertex(Point2(1.9500, 0.9916));
+    poly.append_vertex(Point2(1.9000, 1.0385));
+    poly.append_vertex(Point2(1.8500, 1.0538));
+    poly.append_vertex(Point2(1.8000, 1.0347));
+    poly.append_vertex(Point2(1.7500, 1.0346));
+    poly.append_vertex(Point2(1.7000, 1.0560));
+    poly.append_vertex(Point2(1.6500, 1.0451));
+    poly.append_vertex(Point2(1.6000, 0.9992));
+    poly.append_vertex(Point2(1.5500, 0.9757));
+    poly.append_vertex(Point2(1.5000, 0.9849));
+    poly.append_vertex(Point2(1.4500, 0.9753));
+    poly.append_vertex(Point2(1.4000, 0.9400));
+    poly.append_vertex(Point2(1.3500, 0.9340));
+    poly.append_vertex(Point2(1.3000, 0.9689));
+    poly.append_vertex(Point2(1.2500, 0.9902));
+    poly.append_vertex(Point2(1.2000, 0.9817));
+    poly.append_vertex(Point2(1.1500, 0.9934));
+    poly.append_vertex(Point2(1.1000, 1.0381));
+    poly.append_vertex(Point2(1.0500, 1.0609));
+    poly.append_vertex(Point2(1.0100, 1.0495));
+    poly.append_vertex(Point2(1.0100, 0.4500));
+    poly.append_vertex(Point2(0.9900, 0.4500));
+    poly.append_vertex(Point2(0.9900, 1.0495));
+    poly.append_vertex(Point2(0.9500, 1.0299));
+    poly.append_vertex(Point2(0.9000, 1.0470));
+    poly.append_vertex(Point2(0.8500, 1.0435));
+    poly.append_vertex(Point2(0.8000, 0.9993));
+    poly.append_vertex(Point2(0.7500, 0.9670));
+    poly.append_vertex(Point2(0.7000, 0.9742));
+    poly.append_vertex(Point2(0.6500, 0.9751));
+    poly.append_vertex(Point2(0.6000, 0.9453));
+    poly.append_vertex(Point2(0.5500, 0.9329));
+    poly.append_vertex(Point2(0.5000, 0.9663));
+    poly.append_vertex(Point2(0.4500, 0.9975));
+    poly.append_vertex(Point2(0.4000, 0.9938));
+    poly.append_vertex(Point2(0.3500, 0.9970));
+    poly.append_vertex(Point2(0.3000, 1.0363));
+    poly.append_vertex(Point2(0.2500, 1.0654));
+    poly.append_vertex(Point2(0.2000, 1.0483));
+    poly.append_vertex(Point2(0.1500, 1.0266));
+    poly.append_vertex(Point2(0.1000, 1.0367));
+    poly.append_vertex(Point2(0.0500, 1.0395));
+    poly.append_vertex(Point2(0.0000, 1.0000));
+
+    return poly;
+}
+
 } // namespace umeshu
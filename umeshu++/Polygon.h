@@ -13,12 +13,23 @@ class Polygon
 public:
     typedef std::vector<Point2>::iterator       vertex_iterator;
     typedef std::vector<Point2>::const_iterator vertex_const_iterator;
+    typedef std::vector<Polygon>::const_iterator hole_const_iterator;
 
     void append_vertex(Point2 const& vertex) { vertices_.push_back(vertex); }
     size_t number_of_vertices() const { return vertices_.size(); }
 
+    // Holes are polygons lying inside of the outer boundary that do not
+    // touch it or each other. Their orientation does not matter.
+    void add_hole(Polygon const& hole) { holes_.push_back(hole); }
+    size_t number_of_holes() const { return holes_.size(); }
+    hole_const_iterator holes_begin() const { return holes_.begin(); }
+    hole_const_iterator holes_end()   const { return holes_.end(); }
+
     Bounding_box bounding_box() const;
 
+    // positive for counterclockwise polygons, holes are not subtracted
+    double signed_area() const;
+
     vertex_iterator       vertices_begin()       { return vertices_.begin(); }
     vertex_const_iterator vertices_begin() const { return vertices_.begin(); }
     vertex_iterator       vertices_end()         { return vertices_.end(); }
@@ -32,9 +43,11 @@ public:
     static Polygon crack();
     static Polygon coastline();
     static Polygon triangle();
+    static Polygon plate_with_holes();
 
 private:
-    std::vector<Point2> vertices_;
+    std::vector<Point2>  vertices_;
+    std::vector<Polygon> holes_;
 };
 
 } // namespace umeshu
@@ -0,0 +1,109 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "Predicate_statistics.h"
+
+#include <iomanip>
+#include <ostream>
+
+namespace umeshu {
+
+namespace {
+
+Predicate_statistics::Count counters[Predicate_statistics::NUMBER_OF_PREDICATES][Predicate_statistics::NUMBER_OF_STAGES];
+
+} // namespace
+
+Predicate_statistics::Predicate_statistics ()
+{
+    for (int p = 0; p < NUMBER_OF_PREDICATES; ++p) {
+        for (int s = 0; s < NUMBER_OF_STAGES; ++s) {
+            counts_[p][s] = 0;
+        }
+    }
+}
+
+Predicate_statistics::Count Predicate_statistics::calls (Predicate p) const
+{
+    Count n = 0;
+    for (int s = 0; s < NUMBER_OF_STAGES; ++s) {
+        n += counts_[p][s];
+    }
+    return n;
+}
+
+bool Predicate_statistics::enabled ()
+{
+#if defined(UMESHU_PREDICATE_STATISTICS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+Predicate_statistics Predicate_statistics::current ()
+{
+    Predicate_statistics stats;
+    for (int p = 0; p < NUMBER_OF_PREDICATES; ++p) {
+        for (int s = 0; s < NUMBER_OF_STAGES; ++s) {
+            stats.counts_[p][s] = counters[p][s];
+        }
+    }
+    return stats;
+}
+
+void Predicate_statistics::reset ()
+{
+    for (int p = 0; p < NUMBER_OF_PREDICATES; ++p) {
+        for (int s = 0; s < NUMBER_OF_STAGES; ++s) {
+            counters[p][s] = 0;
+        }
+    }
+}
+
+// The predicates are evaluated concurrently by the parallel mesher, so the
+// counters are incremented atomically where the compiler supports it.
+void Predicate_statistics::record (Predicate p, Stage s)
+{
+#if defined(__GNUC__)
+    __sync_fetch_and_add(&counters[p][s], 1);
+#else
+    ++counters[p][s];
+#endif
+}
+
+std::ostream& operator<< (std::ostream& os, Predicate_statistics const& stats)
+{
+    char const* names[] = {"orientation", "incircle"};
+    char const* stage_names[] = {"A", "B", "C", "D"};
+    for (int p = 0; p < Predicate_statistics::NUMBER_OF_PREDICATES; ++p) {
+        Predicate_statistics::Predicate pred = Predicate_statistics::Predicate(p);
+        os << std::setw(12) << std::left << names[p] << std::right
+           << std::setw(12) << stats.calls(pred) << " calls";
+        for (int s = 0; s < Predicate_statistics::NUMBER_OF_STAGES; ++s) {
+            os << std::setw(12) << stats.calls(pred, Predicate_statistics::Stage(s)) << " " << stage_names[s];
+        }
+        os << '\n';
+    }
+    return os;
+}
+
+} // namespace umeshu
@@ -0,0 +1,69 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef __PREDICATE_STATISTICS_H_INCLUDED__
+#define __PREDICATE_STATISTICS_H_INCLUDED__
+
+#include <iosfwd>
+
+namespace umeshu {
+
+// Counts of the evaluations of the exact predicates by the stage that
+// decided the sign: stage A is the floating-point filter, stages B, C and D
+// are the adaptive stages of Shewchuk's predicates, D being the exact
+// expansion arithmetic. The counters are updated only if the library is
+// built with UMESHU_PREDICATE_STATISTICS defined; otherwise they stay zero.
+class Predicate_statistics {
+public:
+    typedef unsigned long long Count;
+
+    enum Predicate {ORIENTATION, INCIRCLE, NUMBER_OF_PREDICATES};
+    enum Stage {STAGE_A, STAGE_B, STAGE_C, STAGE_D, NUMBER_OF_STAGES};
+
+    Predicate_statistics();
+
+    Count calls          (Predicate p) const;
+    Count calls          (Predicate p, Stage s) const { return counts_[p][s]; }
+    Count adaptive_calls (Predicate p) const { return calls(p) - calls(p, STAGE_A); }
+
+    static bool                 enabled ();
+    // counts accumulated since the start or the last reset
+    static Predicate_statistics current ();
+    static void                 reset   ();
+
+    static void record (Predicate p, Stage s);
+
+private:
+    Count counts_[NUMBER_OF_PREDICATES][NUMBER_OF_STAGES];
+};
+
+std::ostream& operator<< (std::ostream& os, Predicate_statistics const& stats);
+
+} // namespace umeshu
+
+#if defined(UMESHU_PREDICATE_STATISTICS)
+#define UMESHU_COUNT_PREDICATE(predicate, stage) \
+    umeshu::Predicate_statistics::record(umeshu::Predicate_statistics::predicate, umeshu::Predicate_statistics::stage)
+#else
+#define UMESHU_COUNT_PREDICATE(predicate, stage) ((void) 0)
+#endif
+
+#endif // __PREDICATE_STATISTICS_H_INCLUDED__
@@ -36,9 +36,9 @@
 /*  First, read the short or long version of the paper (from the Web page    */
 /*    above).                                                                */
 /*                                                                           */
-/*  Be sure to call exactinit() once, before calling any of the arithmetic   */
-/*    functions or geometric predicates.  Also be sure to turn on the        */
-/*    optimizer when compiling this file.                                    */
+/*  The constants of exactinit() are fixed below for IEEE doubles, so no     */
+/*    initialization is needed.  Be sure to turn on the optimizer when       */
+/*    compiling this file.                                                   */
 /*                                                                           */
 /*                                                                           */
 /*  Several geometric predicates are defined.  Their parameters are all      */
@@ -114,11 +114,13 @@
 /*****************************************************************************/
 
 #include <stdlib.h>
+
+#include "Predicate_statistics.h"
 // #include <stdio.h>
 // #include <math.h>
 // #include <sys/time.h>
 
-// #include "Predicates.h"
+#include "Predicates.h"
 
 /* On some machines, the exact arithmetic routines might be defeated by the  */
 /*   use of internal extended precision floating-point registers.  Sometimes */
@@ -360,14 +362,11 @@
   Square(a1, _j, _1); \
   Two_Two_Sum(_j, _1, _l, _2, x5, x4, x3, x2)
 
-REAL splitter;     /* = 2^ceiling(p / 2) + 1.  Used to split floats in half. */
-REAL epsilon;                /* = 2^(-p).  Used to estimate roundoff errors. */
-/* A set of coefficients used to calculate maximum roundoff errors.          */
-REAL resulterrbound;
-REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
-REAL o3derrboundA, o3derrboundB, o3derrboundC;
-REAL iccerrboundA, iccerrboundB, iccerrboundC;
-REAL isperrboundA, isperrboundB, isperrboundC;
+/*  The constants that exactinit() of the original code computes at runtime */
+/*    are fixed for IEEE 754 double precision in Predicates.h, where the     */
+/*    kernels share the error bounds of the filters.                         */
+
+using namespace umeshu::predicates;
 
 /*****************************************************************************/
 /*                                                                           */
@@ -623,67 +622,6 @@ float uniformfloatrand()
   return result;
 }
 
-/*****************************************************************************/
-/*                                                                           */
-/*  exactinit()   Initialize the variables used for exact arithmetic.        */
-/*                                                                           */
-/*  `epsilon' is the largest power of two such that 1.0 + epsilon = 1.0 in   */
-/*  floating-point arithmetic.  `epsilon' bounds the relative roundoff       */
-/*  error.  It is used for floating-point error analysis.                    */
-/*                                                                           */
-/*  `splitter' is used to split floating-point numbers into two half-        */
-/*  length significands for exact multiplication.                            */
-/*                                                                           */
-/*  I imagine that a highly optimizing compiler might be too smart for its   */
-/*  own good, and somehow cause this routine to fail, if it pretends that    */
-/*  floating-point arithmetic is too much like real arithmetic.              */
-/*                                                                           */
-/*  Don't change this routine unless you fully understand it.                */
-/*                                                                           */
-/*****************************************************************************/
-
-void exactinit(void)
-{
-  REAL half;
-  REAL check, lastcheck;
-  int every_other;
-
-  every_other = 1;
-  half = 0.5;
-  epsilon = 1.0;
-  splitter = 1.0;
-  check = 1.0;
-  /* Repeatedly divide `epsilon' by two until it is too small to add to    */
-  /*   one without causing roundoff.  (Also check if the sum is equal to   */
-  /*   the previous sum, for machines that round up instead of using exact */
-  /*   rounding.  Not that this library will work on such machines anyway. */
-  do {
-    lastcheck = check;
-    epsilon *= half;
-    if (every_other) {
-      splitter *= 2.0;
-    }
-    every_other = !every_other;
-    check = 1.0 + epsilon;
-  } while ((check != 1.0) && (check != lastcheck));
-  splitter += 1.0;
-
-  /* Error bounds for orientation and incircle tests. */
-  resulterrbound = (3.0 + 8.0 * epsilon) * epsilon;
-  ccwerrboundA = (3.0 + 16.0 * epsilon) * epsilon;
-  ccwerrboundB = (2.0 + 12.0 * epsilon) * epsilon;
-  ccwerrboundC = (9.0 + 64.0 * epsilon) * epsilon * epsilon;
-  o3derrboundA = (7.0 + 56.0 * epsilon) * epsilon;
-  o3derrboundB = (3.0 + 28.0 * epsilon) * epsilon;
-  o3derrboundC = (26.0 + 288.0 * epsilon) * epsilon * epsilon;
-  iccerrboundA = (10.0 + 96.0 * epsilon) * epsilon;
-  iccerrboundB = (4.0 + 48.0 * epsilon) * epsilon;
-  iccerrboundC = (44.0 + 576.0 * epsilon) * epsilon * epsilon;
-  isperrboundA = (16.0 + 224.0 * epsilon) * epsilon;
-  isperrboundB = (5.0 + 72.0 * epsilon) * epsilon;
-  isperrboundC = (71.0 + 1408.0 * epsilon) * epsilon * epsilon;
-}
-
 /*****************************************************************************/
 /*                                                                           */
 /*  grow_expansion()   Add a scalar to an expansion.                         */
@@ -1508,6 +1446,7 @@ REAL orient2dadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL detsum)
   det = estimate(4, B);
   errbound = ccwerrboundB * detsum;
   if ((det >= errbound) || (-det >= errbound)) {
+    UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_B);
     return det;
   }
 
@@ -1518,6 +1457,7 @@ REAL orient2dadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL detsum)
 
   if ((acxtail == 0.0) && (acytail == 0.0)
       && (bcxtail == 0.0) && (bcytail == 0.0)) {
+    UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_B);
     return det;
   }
 
@@ -1525,6 +1465,7 @@ REAL orient2dadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL detsum)
   det += (acx * bcytail + bcy * acxtail)
        - (acy * bcxtail + bcx * acytail);
   if ((det >= errbound) || (-det >= errbound)) {
+    UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_C);
     return det;
   }
 
@@ -1546,6 +1487,7 @@ REAL orient2dadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL detsum)
   u[3] = u3;
   Dlength = fast_expansion_sum_zeroelim(C2length, C2, 4, u, D);
 
+  UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_D);
   return(D[Dlength - 1]);
 }
 
@@ -1560,22 +1502,26 @@ REAL orient2d(REAL const* pa, REAL const* pb, REAL const* pc)
 
   if (detleft > 0.0) {
     if (detright <= 0.0) {
+      UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_A);
       return det;
     } else {
       detsum = detleft + detright;
     }
   } else if (detleft < 0.0) {
     if (detright >= 0.0) {
+      UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_A);
       return det;
     } else {
       detsum = -detleft - detright;
     }
   } else {
+    UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_A);
     return det;
   }
 
   errbound = ccwerrboundA * detsum;
   if ((det >= errbound) || (-det >= errbound)) {
+    UMESHU_COUNT_PREDICATE(ORIENTATION, STAGE_A);
     return det;
   }
 
@@ -2651,6 +2597,7 @@ REAL incircleadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL const* p
   det = estimate(finlength, fin1);
   errbound = iccerrboundB * permanent;
   if ((det >= errbound) || (-det >= errbound)) {
+    UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_B);
     return det;
   }
 
@@ -2662,6 +2609,7 @@ REAL incircleadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL const* p
   Two_Diff_Tail(pc[1], pd[1], cdy, cdytail);
   if ((adxtail == 0.0) && (bdxtail == 0.0) && (cdxtail == 0.0)
       && (adytail == 0.0) && (bdytail == 0.0) && (cdytail == 0.0)) {
+    UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_B);
     return det;
   }
 
@@ -2676,6 +2624,7 @@ REAL incircleadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL const* p
                                      - (ady * bdxtail + bdx * adytail))
           + 2.0 * (cdx * cdxtail + cdy * cdytail) * (adx * bdy - ady * bdx));
   if ((det >= errbound) || (-det >= errbound)) {
+    UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_C);
     return det;
   }
 
@@ -3111,6 +3060,7 @@ REAL incircleadapt(REAL const* pa, REAL const* pb, REAL const* pc, REAL const* p
     }
   }
 
+  UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_D);
   return finnow[finlength - 1];
 }
 
@@ -3150,6 +3100,7 @@ REAL incircle(REAL const* pa, REAL const* pb, REAL const* pc, REAL const* pd)
             + (Absolute(adxbdy) + Absolute(bdxady)) * clift;
   errbound = iccerrboundA * permanent;
   if ((det > errbound) || (-det > errbound)) {
+    UMESHU_COUNT_PREDICATE(INCIRCLE, STAGE_A);
     return det;
   }
 
@@ -0,0 +1,61 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef __PREDICATES_H_INCLUDED__
+#define __PREDICATES_H_INCLUDED__
+
+// Interface of the adaptive predicates of J. R. Shewchuk in Predicates.cpp.
+
+double orient2d(double const* pa, double const* pb, double const* pc);
+double incircle(double const* pa, double const* pb, double const* pc, double const* pd);
+// adaptive stages, called when the floating-point filter cannot decide
+double orient2dadapt(double const* pa, double const* pb, double const* pc, double detsum);
+double incircleadapt(double const* pa, double const* pb, double const* pc, double const* pd, double permanent);
+
+namespace umeshu {
+
+namespace predicates {
+
+// The constants that exactinit() of the original code computes at run
+// time, fixed for IEEE 754 double precision (p = 53). The error bounds
+// of the floating-point filters are shared by Predicates.cpp and the
+// kernels.
+static const double splitter = 134217729.0;            // 2^ceiling(p/2) + 1, splits doubles in half
+static const double epsilon = 1.1102230246251565404e-16; // 2^-p, estimates roundoff errors
+static const double resulterrbound = (3.0 + 8.0 * epsilon) * epsilon;
+static const double ccwerrboundA = (3.0 + 16.0 * epsilon) * epsilon;
+static const double ccwerrboundB = (2.0 + 12.0 * epsilon) * epsilon;
+static const double ccwerrboundC = (9.0 + 64.0 * epsilon) * epsilon * epsilon;
+static const double o3derrboundA = (7.0 + 56.0 * epsilon) * epsilon;
+static const double o3derrboundB = (3.0 + 28.0 * epsilon) * epsilon;
+static const double o3derrboundC = (26.0 + 288.0 * epsilon) * epsilon * epsilon;
+static const double iccerrboundA = (10.0 + 96.0 * epsilon) * epsilon;
+static const double iccerrboundB = (4.0 + 48.0 * epsilon) * epsilon;
+static const double iccerrboundC = (44.0 + 576.0 * epsilon) * epsilon * epsilon;
+static const double isperrboundA = (16.0 + 224.0 * epsilon) * epsilon;
+static const double isperrboundB = (5.0 + 72.0 * epsilon) * epsilon;
+static const double isperrboundC = (71.0 + 1408.0 * epsilon) * epsilon * epsilon;
+
+} // namespace predicates
+
+} // namespace umeshu
+
+#endif /* __PREDICATES_H_INCLUDED__ */
@@ -0,0 +1,107 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef __QUALITY_STATISTICS_H_INCLUDED__
+#define __QUALITY_STATISTICS_H_INCLUDED__
+
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace umeshu {
+
+// Summary of the shape of the faces and of the lengths of the edges of a
+// mesh. The angles are in degrees.
+struct Quality_statistics {
+    Quality_statistics()
+        : number_of_faces(0)
+        , minimum_angle(0.0)
+        , mean_minimum_angle(0.0)
+        , shortest_edge(0.0)
+        , longest_edge(0.0)
+    {}
+
+    size_t number_of_faces;
+    double minimum_angle;
+    double mean_minimum_angle;
+    double shortest_edge;
+    double longest_edge;
+};
+
+// The faces and the edges are gathered in batches and measured by the
+// batched constructions of the kernel.
+template <typename Triangulation>
+Quality_statistics quality_statistics (Triangulation const& tria)
+{
+    typedef typename Triangulation::Kernel  Kernel;
+    typedef typename Kernel::Point_2        Point_2;
+    size_t const batch_size = 64;
+
+    Point_2 p1[batch_size], p2[batch_size], p3[batch_size];
+    double values[batch_size];
+
+    Quality_statistics stats;
+    double min_angle = std::numeric_limits<double>::max();
+    double sum_min_angles = 0.0;
+    typename Triangulation::Face_const_iterator face = tria.faces_begin();
+    while (face != tria.faces_end()) {
+        size_t n = 0;
+        for (; n < batch_size && face != tria.faces_end(); ++n, ++face) {
+            face->vertices(p1[n], p2[n], p3[n]);
+        }
+        Kernel::minimum_angles(p1, p2, p3, n, values);
+        for (size_t i = 0; i < n; ++i) {
+            min_angle = std::min(min_angle, values[i]);
+            sum_min_angles += values[i];
+        }
+        stats.number_of_faces += n;
+    }
+    if (stats.number_of_faces > 0) {
+        stats.minimum_angle = utils::radians_to_degrees(min_angle);
+        stats.mean_minimum_angle = utils::radians_to_degrees(sum_min_angles/stats.number_of_faces);
+    }
+
+    double shortest = std::numeric_limits<double>::max();
+    double longest = 0.0;
+    typename Triangulation::Edge_const_iterator edge = tria.edges_begin();
+    while (edge != tria.edges_end()) {
+        size_t n = 0;
+        for (; n < batch_size && edge != tria.edges_end(); ++n, ++edge) {
+            edge->vertices(p1[n], p2[n]);
+        }
+        Kernel::distances(p1, p2, n, values);
+        for (size_t i = 0; i < n; ++i) {
+            shortest = std::min(shortest, values[i]);
+            longest = std::max(longest, values[i]);
+        }
+    }
+    if (longest > 0.0) {
+        stats.shortest_edge = shortest;
+        stats.longest_edge = longest;
+    }
+    return stats;
+}
+
+} // namespace umeshu
+
+#endif // __QUALITY_STATISTICS_H_INCLUDED__
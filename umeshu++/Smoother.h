@@ -24,11 +24,18 @@
 
 namespace umeshu {
 
+// Laplacian smoothing: every interior node is moved to the mean of its
+// neighbours. The nodes are moved through Delaunay_triangulation::move_node,
+// so the quality cached in the faces stays valid; the Delaunay property is
+// not restored, call make_cdt afterwards.
 template<typename Mesh>
 class Smoother
 {
 public:
-    typedef typename Mesh::kernel_type kernel_type;
+    typedef typename Mesh::Kernel          Kernel;
+    typedef typename Kernel::Point_2       Point_2;
+    typedef typename Mesh::Node_iterator   Node_iterator;
+    typedef typename Mesh::Halfedge_handle Halfedge_handle;
 
     void smooth(Mesh &mesh, int niter);
 
@@ -47,21 +54,21 @@ void Smoother<Mesh>::smooth(Mesh &mesh, int niter)
 template<typename Mesh>
 void Smoother<Mesh>::smooth_once(Mesh &mesh)
 {
-    typename Mesh::nodes_iterator nodes_iter = mesh.nodes_begin();
-    for(; nodes_iter != mesh.nodes_end(); ++nodes_iter) {
-        NodeHandle node = *nodes_iter;
-        if (node->is_boundary()) {
+    for (Node_iterator node = mesh.nodes_begin(); node != mesh.nodes_end(); ++node) {
+        if (node->is_isolated() || node->is_boundary()) {
             continue;
         }
-        Point2 new_pos;
+        Point_2 new_pos(0.0, 0.0);
         int n = node->degree();
-        HalfEdgeHandle he_start = node->out_he()->pair();
-        HalfEdgeHandle he_iter = he_start;
+        Halfedge_handle he_start = node->halfedge();
+        Halfedge_handle he_iter = he_start;
         do {
-            new_pos += he_iter->origin()->position()/n;
-            he_iter = he_iter->next()->pair();
+            Point_2 neighbour = he_iter->pair()->origin()->position();
+            neighbour /= n;
+            new_pos += neighbour;
+            he_iter = he_iter->pair()->next();
         } while (he_iter != he_start);
-        node->position() = new_pos;
+        mesh.move_node(node, new_pos);
     }
 }
 
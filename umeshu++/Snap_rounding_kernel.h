@@ -0,0 +1,127 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+
+#ifndef __SNAP_ROUNDING_KERNEL_H_INCLUDED__
+#define __SNAP_ROUNDING_KERNEL_H_INCLUDED__
+
+#include "Exact_adaptive_kernel.h"
+#include "Exceptions.h"
+
+#include <boost/cstdint.hpp>
+
+#include <cmath>
+
+namespace umeshu {
+
+// Kernel for inputs with fixed-precision coordinates. The points live on
+// the grid of spacing 2^-Fraction_bits: the constructions snap their
+// results to the nearest grid point and the predicates treat every point
+// as its nearest grid point. Triangulations snap the positions of the
+// nodes they add, input vertices included. On integer grid coordinates,
+// the orientation test is evaluated exactly in 64-bit and the incircle
+// test in 128-bit integer arithmetic, with no floating-point expansions.
+// The grid coordinates must be smaller than 2^29 in absolute value, i.e.,
+// the points must lie within 2^(29-Fraction_bits) of the origin,
+// otherwise coordinate_range_error is thrown.
+template <int Fraction_bits>
+class Snap_rounding_kernel : public Exact_adaptive_kernel {
+    public:
+        struct coordinate_range_error : virtual umeshu_error { };
+
+        static Point_2 snap (Point_2 const& p) {
+            return Point_2(std::ldexp(static_cast<double>(to_grid(p.x())), -Fraction_bits),
+                           std::ldexp(static_cast<double>(to_grid(p.y())), -Fraction_bits));
+        }
+
+        static Oriented_side oriented_side (Point_2 const& pa, Point_2 const& pb, Point_2 const& test) {
+            boost::int64_t tx = to_grid(test.x()), ty = to_grid(test.y());
+            boost::int64_t acx = to_grid(pa.x()) - tx, acy = to_grid(pa.y()) - ty;
+            boost::int64_t bcx = to_grid(pb.x()) - tx, bcy = to_grid(pb.y()) - ty;
+            // the differences have at most 30 bits, the products 60
+            return sign(acx*bcy - acy*bcx);
+        }
+
+        static Oriented_side oriented_circle (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc, Point_2 const& test) {
+            boost::int64_t tx = to_grid(test.x()), ty = to_grid(test.y());
+            boost::int64_t adx = to_grid(pa.x()) - tx, ady = to_grid(pa.y()) - ty;
+            boost::int64_t bdx = to_grid(pb.x()) - tx, bdy = to_grid(pb.y()) - ty;
+            boost::int64_t cdx = to_grid(pc.x()) - tx, cdy = to_grid(pc.y()) - ty;
+            // the lifts and the minors have at most 61 bits, their products
+            // 122 and the determinant 124
+            __int128 alift = adx*adx + ady*ady;
+            __int128 blift = bdx*bdx + bdy*bdy;
+            __int128 clift = cdx*cdx + cdy*cdy;
+            __int128 det = alift*(bdx*cdy - cdx*bdy) + blift*(cdx*ady - adx*cdy) + clift*(adx*bdy - bdx*ady);
+            return det > 0 ? ON_POSITIVE_SIDE : (det < 0 ? ON_NEGATIVE_SIDE : ON_ORIENTED_BOUNDARY);
+        }
+
+        static void oriented_sides (Point_2 const& pa, Point_2 const& pb, Point_2 const* tests, size_t n, Oriented_side* results) {
+            Scalar_batched_predicates<Snap_rounding_kernel>::oriented_sides(pa, pb, tests, n, results);
+        }
+
+        static void oriented_circles (Point_2 const* pa, Point_2 const* pb, Point_2 const* pc, Point_2 const* tests, size_t n, Oriented_side* results) {
+            Scalar_batched_predicates<Snap_rounding_kernel>::oriented_circles(pa, pb, pc, tests, n, results);
+        }
+
+        static double signed_area (Point_2 const& pa, Point_2 const& pb, Point_2 const& pc) {
+            boost::int64_t cx = to_grid(pc.x()), cy = to_grid(pc.y());
+            boost::int64_t acx = to_grid(pa.x()) - cx, acy = to_grid(pa.y()) - cy;
+            boost::int64_t bcx = to_grid(pb.x()) - cx, bcy = to_grid(pb.y()) - cy;
+            return std::ldexp(0.5*static_cast<double>(acx*bcy - acy*bcx), -2*Fraction_bits);
+        }
+
+        static Point_2 circumcenter (Point_2 const& p1, Point_2 const& p2, Point_2 const& p3) {
+            return snap(Exact_adaptive_kernel::circumcenter(p1, p2, p3));
+        }
+
+        static void circumcenters (Point_2 const* p1, Point_2 const* p2, Point_2 const* p3, size_t n, Point_2* results) {
+            Exact_adaptive_kernel::circumcenters(p1, p2, p3, n, results);
+            for (size_t i = 0; i < n; ++i) {
+                results[i] = snap(results[i]);
+            }
+        }
+
+        static Point_2 offcenter (Point_2 const& p1, Point_2 const& p2, Point_2 const& p3, double offconstant) {
+            return snap(Exact_adaptive_kernel::offcenter(p1, p2, p3, offconstant));
+        }
+
+        static Point_2 midpoint (Point_2 const& p1, Point_2 const& p2) {
+            return snap(Exact_adaptive_kernel::midpoint(p1, p2));
+        }
+
+        static Point_2 barycenter (Point_2 const& p1, Point_2 const& p2, Point_2 const& p3) {
+            return snap(Exact_adaptive_kernel::barycenter(p1, p2, p3));
+        }
+
+    private:
+        static boost::int64_t to_grid (double x) {
+            double g = std::floor(std::ldexp(x, Fraction_bits) + 0.5);
+            if (not (std::abs(g) < 536870912.0)) {
+                throw coordinate_range_error();
+            }
+            return static_cast<boost::int64_t>(g);
+        }
+};
+
+} // namespace umeshu
+
+#endif /* __SNAP_ROUNDING_KERNEL_H_INCLUDED__ */
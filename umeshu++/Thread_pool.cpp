@@ -0,0 +1,107 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "Thread_pool.h"
+
+#include <boost/bind.hpp>
+
+namespace umeshu {
+
+Thread_pool::Thread_pool(unsigned number_of_threads)
+: number_of_threads_(number_of_threads > 0 ? number_of_threads : 1)
+, generation_(0)
+, running_(0)
+, stop_(false)
+{
+    for (unsigned i = 1; i < number_of_threads_; ++i) {
+        threads_.create_thread(boost::bind(&Thread_pool::work, this, i));
+    }
+}
+
+Thread_pool::~Thread_pool()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    threads_.join_all();
+}
+
+void Thread_pool::run(Task const& task)
+{
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        task_ = task;
+        error_ = boost::exception_ptr();
+        running_ = number_of_threads_ - 1;
+        ++generation_;
+    }
+    start_.notify_all();
+    call(0);
+    boost::mutex::scoped_lock lock(mutex_);
+    while (running_ > 0) {
+        done_.wait(lock);
+    }
+    task_ = Task();
+    if (error_) {
+        boost::exception_ptr error = error_;
+        error_ = boost::exception_ptr();
+        boost::rethrow_exception(error);
+    }
+}
+
+void Thread_pool::work(unsigned i)
+{
+    unsigned long generation = 0;
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            while (not stop_ && generation_ == generation) {
+                start_.wait(lock);
+            }
+            if (stop_) {
+                return;
+            }
+            generation = generation_;
+        }
+        call(i);
+        boost::mutex::scoped_lock lock(mutex_);
+        if (--running_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+void Thread_pool::call(unsigned i)
+{
+    try {
+        task_(i);
+    }
+    catch (...) {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (not error_) {
+            error_ = boost::current_exception();
+        }
+    }
+}
+
+} // namespace umeshu
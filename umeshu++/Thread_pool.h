@@ -0,0 +1,68 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef __THREAD_POOL_H_INCLUDED__
+#define __THREAD_POOL_H_INCLUDED__
+
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace umeshu {
+
+// Fixed set of threads that are started once and wait between tasks, so
+// that running a short task on all of them does not pay for starting and
+// joining threads.
+class Thread_pool : boost::noncopyable {
+public:
+    typedef boost::function<void (unsigned)> Task;
+
+    explicit Thread_pool(unsigned number_of_threads);
+    ~Thread_pool();
+
+    unsigned number_of_threads() const { return number_of_threads_; }
+
+    // Calls task(i) for i = 0,...,number_of_threads()-1, each on a different
+    // thread, the calling thread taking i = 0, and returns when all the
+    // calls have returned. An exception thrown by a call is rethrown.
+    void run(Task const& task);
+
+private:
+    void work(unsigned i);
+    void call(unsigned i);
+
+    unsigned                  number_of_threads_;
+    boost::thread_group       threads_;
+    boost::mutex              mutex_;
+    boost::condition_variable start_, done_;
+    Task                      task_;
+    unsigned long             generation_;
+    unsigned                  running_;
+    bool                      stop_;
+    boost::exception_ptr      error_;
+};
+
+} // namespace umeshu
+
+#endif // __THREAD_POOL_H_INCLUDED__
@@ -26,6 +26,7 @@
 #include "io/Postscript_ostream.h"
 #include "Bounding_box.h"
 #include "Exact_adaptive_kernel.h"
+#include "Exceptions.h"
 
 #include <boost/assert.hpp>
 
@@ -66,9 +67,11 @@ public:
     typedef typename Base::Edge_const_handle     Edge_const_handle;
     typedef typename Base::Face_const_handle     Face_const_handle;
 
+    // the position is snapped to the grid of the kernel, if it has one, so
+    // that the stored positions are the points the predicates see
     Node_handle add_node (Point_2 const& p) {
         Node_handle n = this->get_new_node();
-        n->position() = p;
+        n->position() = Kernel::snap(p);
         return n;
     }
 
@@ -92,6 +95,22 @@ public:
         return he1;
     }
 
+    // Adds an edge from the destination of in1 to the destination of in2 and
+    // returns its half-edge in that direction. The edge is linked right
+    // after the free half-edges in1 and in2, which selects the gap at nodes
+    // where the boundary passes more than once.
+    Halfedge_handle add_edge (Halfedge_handle in1, Halfedge_handle in2) {
+        BOOST_ASSERT(in1->is_boundary() && in2->is_boundary());
+        Edge_handle e = this->get_new_edge();
+        Halfedge_handle he1 = e->he1();
+        Halfedge_handle he2 = e->he2();
+        he1->set_origin(in1->pair()->origin());
+        attach_edge_after(he1, in1);
+        he2->set_origin(in2->pair()->origin());
+        attach_edge_after(he2, in2);
+        return he1;
+    }
+
     void remove_edge (Edge_handle e) {
         if (not e->he1()->is_boundary()) {
             remove_face(e->he1()->face());
@@ -211,7 +230,11 @@ public:
         return Halfedge_handle();
     }
 
-    Face_handle locate (Point_2 const& p, Point_location& loc, Node_handle& on_node, Edge_handle& on_edge, Face_handle start_face = Face_handle()) {
+    // Walks from start_face towards p. If steps is given, the number of
+    // orientation tests evaluated by the walk is added to it. With an
+    // inexact kernel, a walk that visits more faces than there are in the
+    // mesh is going round in circles and throws topology_error.
+    Face_handle locate (Point_2 const& p, Point_location& loc, Node_handle& on_node, Edge_handle& on_edge, Face_handle start_face = Face_handle(), size_t* steps = NULL) {
         Halfedge_handle he_start;
         if (start_face == Face_handle()) {
             he_start = this->faces_begin()->halfedge();
@@ -219,10 +242,14 @@ public:
             he_start = start_face->halfedge();
         }
         Halfedge_handle he_iter = he_start;
+        size_t faces_visited = 0;
         while (true) {
             Point_2 p1, p2;
             he_iter->vertices(p1, p2);
             typename Kernel::Oriented_side os = Kernel::oriented_side(p1, p2, p);
+            if (steps != NULL) {
+                ++*steps;
+            }
             switch (os) {
                 case Kernel::ON_POSITIVE_SIDE:
                     he_iter = he_iter->next();
@@ -255,6 +282,9 @@ public:
                         on_edge = he_iter->edge();
                         return Face_handle();
                     }
+                    if (not Kernel::has_exact_predicates && ++faces_visited > this->number_of_faces()) {
+                        throw topology_error();
+                    }
                     he_iter = he_iter->pair();
                     he_start = he_iter;
                     he_iter = he_iter->next();
@@ -273,15 +303,19 @@ private:
             Halfedge_handle free_in_he = find_free_incident_halfedge(n);
             // TODO: better handling of this situation? (which should not normally happen)
             BOOST_ASSERT_MSG(free_in_he != Halfedge_handle(), "Did not find free incident half-edge");
-            Halfedge_handle free_out_he = free_in_he->next();
-            BOOST_ASSERT(free_out_he->is_boundary());
-            free_in_he->set_next(he);
-            he->set_prev(free_in_he);
-            he->pair()->set_next(free_out_he); 
-            free_out_he->set_prev(he->pair());
+            attach_edge_after(he, free_in_he);
         }
     }
 
+    void attach_edge_after (Halfedge_handle he, Halfedge_handle free_in_he) {
+        Halfedge_handle free_out_he = free_in_he->next();
+        BOOST_ASSERT(free_out_he->is_boundary());
+        free_in_he->set_next(he);
+        he->set_prev(free_in_he);
+        he->pair()->set_next(free_out_he); 
+        free_out_he->set_prev(he->pair());
+    }
+
     Halfedge_handle find_free_incident_halfedge (Node_handle n) {
         BOOST_ASSERT(not n->is_isolated());
         Halfedge_handle he_start = n->halfedge()->pair();
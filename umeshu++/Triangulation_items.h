@@ -252,6 +252,12 @@ public:
         return Kernel::circumcenter(p1, p2, p3);    
     }
 
+    Point_2 offcenter(double offconstant) const {
+        Point_2 p1, p2, p3;
+        this->vertices(p1, p2, p3);
+        return Kernel::offcenter(p1, p2, p3, offconstant);
+    }
+
 };
 
 struct Triangulation_items {
@@ -27,7 +27,11 @@
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <list>
+#include <utility>
+#include <vector>
 
 namespace umeshu {
 
@@ -47,6 +51,10 @@ public:
     typedef typename Tria::Edge_const_handle     Edge_const_handle;
     typedef typename Tria::Face_const_handle     Face_const_handle;
 
+    // Triangulates the polygon including its holes. The nodes are added in
+    // the order of the vertices, first of the outer boundary and then of
+    // the holes. Throws triangulator_error, or topology_error with an
+    // inexact kernel, when no ear is left before the polygon is covered.
     void triangulate(Polygon const& poly, Tria &tria);
 
     struct triangulator_error : virtual umeshu_error { };
@@ -65,6 +73,33 @@ private:
         return tria.add_edge(prev_node, first_node);
     }
 
+    // the boundary loop of the polygon that has the domain on its left
+    Halfedge_handle add_outer_boundary(Polygon const& poly, Tria& tria) {
+        Halfedge_handle he = add_polygon_to_triangulation(poly, tria);
+        return poly.signed_area() > 0.0 ? he : he->pair();
+    }
+
+    Halfedge_handle add_hole(Polygon const& hole, Tria& tria) {
+        Halfedge_handle he = add_polygon_to_triangulation(hole, tria);
+        return hole.signed_area() > 0.0 ? he->pair() : he;
+    }
+
+    void bridge_hole(Halfedge_handle bhe, Halfedge_handle hole_he, Tria& tria);
+    bool point_is_in_wedge(Halfedge_handle in, Point_2 const& p) const;
+
+    // the half-edge of the loop entering its rightmost node
+    static Halfedge_handle rightmost_halfedge(Halfedge_handle bhe) {
+        Halfedge_handle rightmost = bhe;
+        Halfedge_handle he_iter = bhe->next();
+        while (he_iter != bhe) {
+            if (he_iter->pair()->origin()->position().x() > rightmost->pair()->origin()->position().x()) {
+                rightmost = he_iter;
+            }
+            he_iter = he_iter->next();
+        }
+        return rightmost;
+    }
+
     bool halfedge_origin_is_convex(Halfedge_handle he) const;
     bool halfedge_origin_is_ear(Halfedge_handle he) const;
 
@@ -88,6 +123,11 @@ private:
         }
     }
 
+    template <typename Pair>
+    static bool compare_first(Pair const& p1, Pair const& p2) {
+        return p1.first < p2.first;
+    }
+
     typedef std::list<Halfedge_handle> Halfedges;
     Halfedges reflex_vertices, ears;
 };
@@ -99,14 +139,32 @@ void Triangulator<Triangulation>::triangulate(Polygon const& poly, Triangulation
         throw triangulator_error();
     }
 
-    this->classify_vertices(this->add_polygon_to_triangulation(poly, tria));
+    Halfedge_handle bhe = this->add_outer_boundary(poly, tria);
 
+    // the holes are joined to the boundary by bridge edges from right to
+    // left, so that the boundary loop always lies to the right of the hole
+    // being bridged
+    typedef std::pair<double, Halfedge_handle> Hole;
+    std::vector<Hole> holes;
+    for (Polygon::hole_const_iterator iter = poly.holes_begin(); iter != poly.holes_end(); ++iter) {
+        if (iter->number_of_vertices() < 3) {
+            throw triangulator_error();
+        }
+        Halfedge_handle hole_he = rightmost_halfedge(this->add_hole(*iter, tria));
+        holes.push_back(Hole(-hole_he->pair()->origin()->position().x(), hole_he));
+    }
+    std::stable_sort(holes.begin(), holes.end(), compare_first<Hole>);
+    BOOST_FOREACH(Hole const& hole, holes) {
+        this->bridge_hole(bhe, hole.second, tria);
+    }
+
+    this->classify_vertices(bhe);
+
+    bool covered = false;
     while (not ears.empty()) {
         Halfedge_handle he2 = *ears.begin();
         Halfedge_handle he1 = he2->prev();
         Halfedge_handle he5 = he2->next();
-        Node_handle n1 = he1->origin();
-        Node_handle n3 = he5->origin();
 
         // since we will cut it off, remove the ear from ears. Also, we have to
         // erase he1 and he5 from all the sets, since after cutting the ear we
@@ -120,7 +178,9 @@ void Triangulator<Triangulation>::triangulate(Polygon const& poly, Triangulation
         // if this is not the last ear, i.e., only one triangle left to
         // triangulate
         if (he5 != he1->prev()) {
-            Halfedge_handle he3 = tria.add_edge(n3, n1);
+            // nodes on bridges occur twice on the loop, so the new edge is
+            // linked to the loop explicitly
+            Halfedge_handle he3 = tria.add_edge(he2, he1->prev());
             Halfedge_handle he4 = he3->pair();
             tria.add_face(he1, he2, he3);
 
@@ -143,7 +203,125 @@ void Triangulator<Triangulation>::triangulate(Polygon const& poly, Triangulation
             }
         } else {
             tria.add_face(he1, he2, he5);
+            covered = true;
+        }
+    }
+
+    // the ears run out early on nearly collinear vertices, whose reflex
+    // neighbours block every remaining ear, or when the predicates of an
+    // inexact kernel contradict each other
+    if (not covered) {
+        if (not Kernel::has_exact_predicates) {
+            throw topology_error();
         }
+        throw triangulator_error();
+    }
+}
+
+// Joins the loop of a hole to the boundary loop by an edge from the
+// rightmost node of the hole to a node of the boundary loop visible from it
+// (D. Eberly, Triangulation by Ear Clipping). hole_he enters the rightmost
+// node of the hole.
+template <typename Triangulation>
+void Triangulator<Triangulation>::bridge_hole(Halfedge_handle bhe, Halfedge_handle hole_he, Triangulation &tria)
+{
+    Point_2 m = hole_he->pair()->origin()->position();
+
+    // the nearest edge hit by the ray from m in the direction of the x axis;
+    // the domain lies to the left of the loop, so only the edges going
+    // upwards can be hit from inside
+    Halfedge_handle hit;
+    double hit_x = 0.0;
+    Halfedge_handle he_iter = bhe;
+    do {
+        Point_2 a = he_iter->origin()->position();
+        Point_2 b = he_iter->pair()->origin()->position();
+        if (a.y() <= m.y() && m.y() <= b.y() && a.y() < b.y()) {
+            double x = a.x() + (m.y() - a.y())*(b.x() - a.x())/(b.y() - a.y());
+            if (x >= m.x() && (hit == Halfedge_handle() || x < hit_x)) {
+                hit = he_iter;
+                hit_x = x;
+            }
+        }
+        he_iter = he_iter->next();
+    } while (he_iter != bhe);
+    if (hit == Halfedge_handle()) {
+        throw triangulator_error();
+    }
+
+    // the endpoint of the hit edge further right is the candidate; if the
+    // ray hits a node, it is the visible node
+    Point_2 a = hit->origin()->position();
+    Point_2 b = hit->pair()->origin()->position();
+    Point_2 i(hit_x, m.y());
+    Node_handle visible;
+    if (a.y() == m.y()) {
+        visible = hit->origin();
+    } else if (b.y() == m.y()) {
+        visible = hit->pair()->origin();
+    } else {
+        visible = a.x() > b.x() ? hit->origin() : hit->pair()->origin();
+
+        // reflex nodes inside of the triangle (m, i, visible) can hide the
+        // candidate; the one with the smallest angle to the ray is visible
+        Point_2 p = visible->position();
+        double best_slope = std::abs(p.y() - m.y())/(p.x() - m.x());
+        double best_dist = Kernel::distance(m, p);
+        he_iter = bhe;
+        do {
+            Node_handle n = he_iter->origin();
+            Point_2 r = n->position();
+            if (n != visible && r.x() > m.x() && not halfedge_origin_is_convex(he_iter)) {
+                typename Kernel::Oriented_side os1, os2, os3;
+                os1 = Kernel::oriented_side(m, i, r);
+                os2 = Kernel::oriented_side(i, p, r);
+                os3 = Kernel::oriented_side(p, m, r);
+                if ((os1 != Kernel::ON_NEGATIVE_SIDE && os2 != Kernel::ON_NEGATIVE_SIDE && os3 != Kernel::ON_NEGATIVE_SIDE) ||
+                    (os1 != Kernel::ON_POSITIVE_SIDE && os2 != Kernel::ON_POSITIVE_SIDE && os3 != Kernel::ON_POSITIVE_SIDE)) {
+                    double slope = std::abs(r.y() - m.y())/(r.x() - m.x());
+                    double dist = Kernel::distance(m, r);
+                    if (slope < best_slope || (slope == best_slope && dist < best_dist)) {
+                        visible = n;
+                        best_slope = slope;
+                        best_dist = dist;
+                    }
+                }
+            }
+            he_iter = he_iter->next();
+        } while (he_iter != bhe);
+    }
+
+    // the visible node can occur on the loop more than once; the bridge
+    // leaves it from the gap that m lies in
+    Halfedge_handle in;
+    he_iter = bhe;
+    do {
+        if (he_iter->pair()->origin() == visible && point_is_in_wedge(he_iter, m)) {
+            in = he_iter;
+            break;
+        }
+        he_iter = he_iter->next();
+    } while (he_iter != bhe);
+    if (in == Halfedge_handle()) {
+        throw triangulator_error();
+    }
+
+    tria.add_edge(in, hole_he);
+}
+
+// true if p lies in the interior angle of the loop at the destination of in
+template <typename Triangulation>
+bool Triangulator<Triangulation>::point_is_in_wedge(Halfedge_handle in, Point_2 const& p) const
+{
+    Point_2 p1 = in->origin()->position();
+    Point_2 p2 = in->pair()->origin()->position();
+    Point_2 p3 = in->next()->pair()->origin()->position();
+    bool left_of_in = Kernel::oriented_side(p1, p2, p) != Kernel::ON_NEGATIVE_SIDE;
+    bool left_of_out = Kernel::oriented_side(p2, p3, p) != Kernel::ON_NEGATIVE_SIDE;
+    if (halfedge_origin_is_convex(in->next())) {
+        return left_of_in and left_of_out;
+    } else {
+        return left_of_in or left_of_out;
     }
 }
 
@@ -178,7 +356,7 @@ bool Triangulator<Triangulation>::halfedge_origin_is_ear(Halfedge_handle he) con
      * vertices */
     BOOST_FOREACH(Halfedge_handle refl_he, reflex_vertices) {
         Node_handle refl_node = refl_he->origin();
-        if (refl_node != n1 && refl_node != n3) {
+        if (refl_node != n1 && refl_node != n2 && refl_node != n3) {
             typename Kernel::Oriented_side os1, os2, os3;
             Point_2 p = refl_node->position();
             os1 = Kernel::oriented_side(p1, p2, p);
@@ -0,0 +1,77 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+// Refines a polygon across the processes of MPI_COMM_WORLD and writes the
+// subdomain of every process to its own file mesh_<rank>.eps. Run with,
+// e.g., mpirun -np 4 umeshu-meshgen-mpi [max_area [min_angle]].
+
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Distributed_mesher.h"
+#include "Exceptions.h"
+#include "Polygon.h"
+#include "Triangulator.h"
+#include "io/Postscript_ostream.h"
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/environment.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace umeshu;
+
+typedef Delaunay_triangulation<Delaunay_triangulation_items> Mesh;
+typedef Distributed_mesher<Mesh> Mesher;
+
+int main (int argc, char * argv[])
+{
+    boost::mpi::environment env(argc, argv);
+    boost::mpi::communicator world;
+    double max_area = argc > 1 ? std::atof(argv[1]) : 0.001;
+    double min_angle = argc > 2 ? std::atof(argv[2]) : 25.0;
+
+    try {
+        Polygon boundary = Polygon::kidney();
+        Mesh mesh;
+        if (world.rank() == 0) {
+            Triangulator<Mesh> triangulator;
+            triangulator.triangulate(boundary, mesh);
+            mesh.make_cdt();
+        }
+        Mesher mesher(world);
+        mesher.refine(mesh, max_area, min_angle);
+
+        std::ostringstream name;
+        name << "mesh_" << world.rank() << ".eps";
+        io::Postscript_ostream ps(name.str(), boundary.bounding_box());
+        ps << mesh;
+        std::cout << "Rank " << world.rank() << ": " << mesh.number_of_nodes() << " nodes, "
+                  << mesh.number_of_faces() << " faces after " << mesher.rounds() << " rounds" << std::endl;
+    }
+    catch (boost::exception & e) {
+        std::cerr << boost::diagnostic_information(e);
+        return 1;
+    }
+
+    return 0;
+}
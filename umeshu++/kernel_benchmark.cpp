@@ -0,0 +1,193 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+// Refines the built-in polygons with every kernel and prints the times,
+// then times the scalar and the batched predicates of every kernel on
+// random points.
+
+#include "Bounding_box.h"
+#include "Delaunay_mesher.h"
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Exact_adaptive_kernel.h"
+#include "Exceptions.h"
+#include "Fast_kernel.h"
+#include "Interval_filtered_kernel.h"
+#include "Polygon.h"
+#include "Snap_rounding_kernel.h"
+#include "Triangulator.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace umeshu;
+
+struct Shape {
+    Shape (std::string const& name, Polygon const& polygon) : name(name), polygon(polygon) { }
+    std::string name;
+    Polygon     polygon;
+};
+
+// Refines the polygon to about number_of_faces faces and returns the time
+// taken by triangulation and refinement in seconds.
+template <typename Kernel>
+double refine (Polygon const& polygon, size_t number_of_faces, size_t& number_of_nodes)
+{
+    typedef Delaunay_triangulation<Delaunay_triangulation_items, Kernel> Mesh;
+
+    Bounding_box bb = polygon.bounding_box();
+    double max_area = bb.width()*bb.height()/number_of_faces;
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    Mesh mesh;
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(polygon, mesh);
+    mesh.make_cdt();
+    Delaunay_mesher<Mesh> mesher;
+    mesher.refine(mesh, max_area, 20.0);
+    boost::posix_time::ptime stop = boost::posix_time::microsec_clock::universal_time();
+
+    number_of_nodes = mesh.number_of_nodes();
+    return (stop - start).total_microseconds()*1e-6;
+}
+
+static double elapsed_since (boost::posix_time::ptime start)
+{
+    boost::posix_time::ptime stop = boost::posix_time::microsec_clock::universal_time();
+    return (stop - start).total_microseconds()*1e-6;
+}
+
+// Classifies random points against random lines and circles, one point at
+// a time and in batches of the size used by the triangulator and by
+// make_cdt, and prints the best times in seconds.
+template <typename Kernel>
+void run_predicates (std::string const& kernel, size_t number_of_tests, int repetitions)
+{
+    size_t const batch_size = 64;
+    std::vector<Point2> pa(number_of_tests), pb(number_of_tests), pc(number_of_tests), tests(number_of_tests);
+    std::srand(1);
+    for (size_t i = 0; i < number_of_tests; ++i) {
+        pa[i] = Point2(std::rand()/double(RAND_MAX), std::rand()/double(RAND_MAX));
+        pb[i] = Point2(std::rand()/double(RAND_MAX), std::rand()/double(RAND_MAX));
+        pc[i] = Point2(std::rand()/double(RAND_MAX), std::rand()/double(RAND_MAX));
+        tests[i] = Point2(std::rand()/double(RAND_MAX), std::rand()/double(RAND_MAX));
+    }
+    std::vector<typename Kernel::Oriented_side> results(number_of_tests);
+
+    double best[4] = {0.0, 0.0, 0.0, 0.0};
+    for (int r = 0; r < repetitions; ++r) {
+        double seconds[4];
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        for (size_t i = 0; i < number_of_tests; ++i) {
+            results[i] = Kernel::oriented_side(pa[i/batch_size], pb[i/batch_size], tests[i]);
+        }
+        seconds[0] = elapsed_since(start);
+        start = boost::posix_time::microsec_clock::universal_time();
+        for (size_t i = 0; i < number_of_tests; i += batch_size) {
+            Kernel::oriented_sides(pa[i/batch_size], pb[i/batch_size], &tests[i], std::min(batch_size, number_of_tests - i), &results[i]);
+        }
+        seconds[1] = elapsed_since(start);
+        start = boost::posix_time::microsec_clock::universal_time();
+        for (size_t i = 0; i < number_of_tests; ++i) {
+            results[i] = Kernel::oriented_circle(pa[i], pb[i], pc[i], tests[i]);
+        }
+        seconds[2] = elapsed_since(start);
+        start = boost::posix_time::microsec_clock::universal_time();
+        for (size_t i = 0; i < number_of_tests; i += batch_size) {
+            Kernel::oriented_circles(&pa[i], &pb[i], &pc[i], &tests[i], std::min(batch_size, number_of_tests - i), &results[i]);
+        }
+        seconds[3] = elapsed_since(start);
+        for (int k = 0; k < 4; ++k) {
+            best[k] = r == 0 ? seconds[k] : std::min(best[k], seconds[k]);
+        }
+    }
+    char const* names[4] = {"oriented_side", "oriented_sides", "oriented_circle", "oriented_circles"};
+    for (int k = 0; k < 4; ++k) {
+        std::cout << std::left << std::setw(26) << kernel << std::setw(18) << names[k]
+                  << std::right << std::setw(10) << number_of_tests
+                  << std::setw(12) << std::fixed << std::setprecision(4) << best[k] << std::endl;
+    }
+}
+
+template <typename Kernel>
+void run (std::string const& kernel, std::vector<Shape> const& shapes, size_t number_of_faces, int repetitions)
+{
+    double total = 0.0;
+    for (std::vector<Shape>::const_iterator iter = shapes.begin(); iter != shapes.end(); ++iter) {
+        size_t number_of_nodes = 0;
+        double best = 0.0;
+        for (int r = 0; r < repetitions; ++r) {
+            double seconds = refine<Kernel>(iter->polygon, number_of_faces, number_of_nodes);
+            best = r == 0 ? seconds : std::min(best, seconds);
+        }
+        total += best;
+        std::cout << std::left << std::setw(26) << kernel << std::setw(18) << iter->name
+                  << std::right << std::setw(10) << number_of_nodes
+                  << std::setw(12) << std::fixed << std::setprecision(4) << best << std::endl;
+    }
+    std::cout << std::left << std::setw(26) << kernel << std::setw(18) << "total"
+              << std::right << std::setw(22) << std::fixed << std::setprecision(4) << total << std::endl;
+}
+
+int main (int argc, const char * argv[])
+{
+    size_t number_of_faces = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    std::vector<Shape> shapes;
+    shapes.push_back(Shape("island", Polygon::island()));
+    shapes.push_back(Shape("letter_a", Polygon::letter_a()));
+    shapes.push_back(Shape("letter_u", Polygon::letter_u()));
+    shapes.push_back(Shape("kidney", Polygon::kidney()));
+    shapes.push_back(Shape("crack", Polygon::crack()));
+    shapes.push_back(Shape("coastline", Polygon::coastline()));
+    shapes.push_back(Shape("triangle", Polygon::triangle()));
+    shapes.push_back(Shape("plate_with_holes", Polygon::plate_with_holes()));
+
+    try {
+        std::cout << std::left << std::setw(26) << "kernel" << std::setw(18) << "polygon"
+                  << std::right << std::setw(10) << "nodes" << std::setw(12) << "seconds" << std::endl;
+        run<Exact_adaptive_kernel>("Exact_adaptive_kernel", shapes, number_of_faces, repetitions);
+        run<Interval_filtered_kernel>("Interval_filtered_kernel", shapes, number_of_faces, repetitions);
+        run<Fast_kernel>("Fast_kernel", shapes, number_of_faces, repetitions);
+        run<Snap_rounding_kernel<20> >("Snap_rounding_kernel<20>", shapes, number_of_faces, repetitions);
+
+        size_t number_of_tests = 50*number_of_faces;
+        std::cout << std::endl << std::left << std::setw(26) << "kernel" << std::setw(18) << "predicate"
+                  << std::right << std::setw(10) << "tests" << std::setw(12) << "seconds" << std::endl;
+        run_predicates<Exact_adaptive_kernel>("Exact_adaptive_kernel", number_of_tests, repetitions);
+        run_predicates<Interval_filtered_kernel>("Interval_filtered_kernel", number_of_tests, repetitions);
+        run_predicates<Fast_kernel>("Fast_kernel", number_of_tests, repetitions);
+        run_predicates<Snap_rounding_kernel<20> >("Snap_rounding_kernel<20>", number_of_tests, repetitions);
+    }
+    catch (boost::exception & e) {
+        std::cerr << boost::diagnostic_information(e);
+        return 1;
+    }
+
+    return 0;
+}
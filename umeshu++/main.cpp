@@ -23,11 +23,13 @@
 // #include "Smoother.h"
 
 #include "Bounding_box.h"
+#include "Coordinate_normalization.h"
 #include "Delaunay_mesher.h"
 #include "Delaunay_triangulation.h"
 #include "Delaunay_triangulation_items.h"
 #include "Exceptions.h"
 #include "Polygon.h"
+#include "Quality_statistics.h"
 #include "Relaxer.h"
 #include "Triangulator.h"
 #include "io/Postscript_ostream.h"
@@ -55,8 +57,15 @@ int main (int argc, const char * argv[])
         // Polygon boundary = Polygon::square(1.0);
         // Polygon boundary = Polygon::island();
         // Polygon boundary = Polygon::triangle();
+        // Polygon boundary = Polygon::plate_with_holes();
         
-        triangulator.triangulate(boundary, mesh);
+        // The mesh is built in coordinates normalized to the unit box and
+        // mapped back at the end; the default-constructed normalization
+        // keeps the coordinates of the polygon.
+        Coordinate_normalization normalization(boundary);
+        // Coordinate_normalization normalization;
+
+        triangulator.triangulate(normalization.normalize(boundary), mesh);
         io::Postscript_ostream ps1("mesh_1.eps", mesh.bounding_box());
         ps1 << mesh;
 
@@ -65,12 +74,13 @@ int main (int argc, const char * argv[])
         ps2 << mesh;
 
         Mesher mesher;
-        mesher.refine(mesh, 0.001, 21.0);
+        mesher.refine(mesh, normalization.normalize_area(0.001), 21.0);
         io::Postscript_ostream ps3("mesh_3.eps", mesh.bounding_box());
         ps3 << mesh;
 
         Relax relax;
         relax.relax(mesh);
+        normalization.denormalize_nodes(mesh);
         io::Postscript_ostream ps4("mesh_4.eps", mesh.bounding_box());
         ps4 << mesh;
 
@@ -91,6 +101,12 @@ int main (int argc, const char * argv[])
         std::cout << "Number of nodes: " << mesh.number_of_nodes() << std::endl;
         std::cout << "Number of edges: " << mesh.number_of_edges() << std::endl;
         std::cout << "Number of faces: " << mesh.number_of_faces() << std::endl;
+        Quality_statistics quality = quality_statistics(mesh);
+        std::cout << "Minimum angle: " << quality.minimum_angle << " (mean " << quality.mean_minimum_angle << ")" << std::endl;
+        std::cout << "Edge lengths: " << quality.shortest_edge << " to " << quality.longest_edge << std::endl;
+        if (Predicate_statistics::enabled()) {
+            std::cout << "Predicate evaluations by stage:\n" << Mesh::Kernel::statistics();
+        }
     }
     catch (boost::exception & e) {
         std::cerr << boost::diagnostic_information(e);
@@ -0,0 +1,124 @@
+//
+//  Copyright (c) 2011 Vladimir Chalupecky
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+// Refines the built-in polygons with Delaunay_mesher and with
+// Parallel_delaunay_mesher on 1, 2, 4, ... threads up to the number of
+// hardware threads and prints the times and the speedups over the serial
+// mesher.
+
+#include "Bounding_box.h"
+#include "Delaunay_mesher.h"
+#include "Delaunay_triangulation.h"
+#include "Delaunay_triangulation_items.h"
+#include "Exact_adaptive_kernel.h"
+#include "Exceptions.h"
+#include "Parallel_delaunay_mesher.h"
+#include "Polygon.h"
+#include "Triangulator.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace umeshu;
+
+typedef Delaunay_triangulation<Delaunay_triangulation_items, Exact_adaptive_kernel> Mesh;
+
+static void triangulate (Polygon const& polygon, Mesh& mesh)
+{
+    Triangulator<Mesh> triangulator;
+    triangulator.triangulate(polygon, mesh);
+    mesh.make_cdt();
+}
+
+// Refines the polygon to about number_of_faces faces with the mesher and
+// returns the best time of refinement alone in seconds.
+template <typename Mesher>
+double refine (Mesher& mesher, Polygon const& polygon, size_t number_of_faces, int repetitions, size_t& number_of_nodes)
+{
+    Bounding_box bb = polygon.bounding_box();
+    double max_area = bb.width()*bb.height()/number_of_faces;
+    double best = 0.0;
+    for (int r = 0; r < repetitions; ++r) {
+        Mesh mesh;
+        triangulate(polygon, mesh);
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        mesher.refine(mesh, max_area, 20.0);
+        boost::posix_time::ptime stop = boost::posix_time::microsec_clock::universal_time();
+        double seconds = (stop - start).total_microseconds()*1e-6;
+        best = r == 0 ? seconds : std::min(best, seconds);
+        number_of_nodes = mesh.number_of_nodes();
+    }
+    return best;
+}
+
+static void print (std::string const& mesher, std::string const& polygon, size_t number_of_nodes, double seconds, double serial_seconds)
+{
+    std::cout << std::left << std::setw(14) << mesher << std::setw(18) << polygon
+              << std::right << std::setw(10) << number_of_nodes
+              << std::setw(12) << std::fixed << std::setprecision(4) << seconds
+              << std::setw(10) << std::setprecision(2) << serial_seconds/seconds << std::endl;
+}
+
+int main (int argc, const char * argv[])
+{
+    size_t number_of_faces = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+    unsigned max_threads = argc > 3 ? std::atoi(argv[3]) : std::max(1u, boost::thread::hardware_concurrency());
+
+    std::vector<std::pair<std::string, Polygon> > shapes;
+    shapes.push_back(std::make_pair(std::string("kidney"), Polygon::kidney()));
+    shapes.push_back(std::make_pair(std::string("island"), Polygon::island()));
+    shapes.push_back(std::make_pair(std::string("plate_with_holes"), Polygon::plate_with_holes()));
+
+    try {
+        std::cout << std::left << std::setw(14) << "mesher" << std::setw(18) << "polygon"
+                  << std::right << std::setw(10) << "nodes" << std::setw(12) << "seconds"
+                  << std::setw(10) << "speedup" << std::endl;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            size_t number_of_nodes = 0;
+            Delaunay_mesher<Mesh> serial;
+            double serial_seconds = refine(serial, shapes[i].second, number_of_faces, repetitions, number_of_nodes);
+            print("serial", shapes[i].first, number_of_nodes, serial_seconds, serial_seconds);
+            for (unsigned n = 1; n <= max_threads; n *= 2) {
+                Parallel_delaunay_mesher<Mesh> parallel(n);
+                double seconds = refine(parallel, shapes[i].second, number_of_faces, repetitions, number_of_nodes);
+                std::ostringstream name;
+                name << "parallel/" << n;
+                print(name.str(), shapes[i].first, number_of_nodes, seconds, serial_seconds);
+            }
+        }
+    }
+    catch (boost::exception & e) {
+        std::cerr << boost::diagnostic_information(e);
+        return 1;
+    }
+
+    return 0;
+}